@@ -0,0 +1,545 @@
+/*
+    Encode/decode throughput benchmarks.
+
+    Every case runs one codec over one generated series until --min-time has elapsed, and
+    reports values/sec, compressed bytes/value, cycles/value and (when perf counters can be
+    opened) branch misses/value. --json writes the same numbers for regression tracking.
+
+        g++ -O3 -std=c++17 -I.. simple8b_bench.cpp -pthread -o simple8b_bench
+        ./simple8b_bench [--filter substring] [--min-time seconds] [--json file]
+
+    Series cover each selector width, all-zero runs, realistic mixed-width data (timestamps,
+    counters, scaled floats) and lengths from a few values, which only reach the careful tail
+    path, to millions.
+*/
+
+#include "simple8b.hpp"
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <string>
+
+#if defined(__linux__)
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#else
+enum
+{
+    PERF_COUNT_HW_CPU_CYCLES = 0,
+    PERF_COUNT_HW_BRANCH_MISSES = 5
+};
+#endif
+
+// hardware counter, read through perf_event_open where allowed
+class Counter
+{
+public:
+    explicit Counter(uint64_t config) : fd(-1)
+    {
+#if defined(__linux__)
+        perf_event_attr attr;
+        memset(&attr, 0, sizeof(attr));
+        attr.type = PERF_TYPE_HARDWARE;
+        attr.size = sizeof(attr);
+        attr.config = config;
+        attr.disabled = 1;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        fd = static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0));
+#else
+        (void)config;
+#endif
+    }
+
+    ~Counter()
+    {
+#if defined(__linux__)
+        if (fd >= 0)
+            close(fd);
+#endif
+    }
+
+    bool Available() const { return fd >= 0; }
+
+    void Start()
+    {
+#if defined(__linux__)
+        if (fd >= 0)
+        {
+            ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+            ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+        }
+#endif
+    }
+
+    uint64_t Stop()
+    {
+        uint64_t count = 0;
+#if defined(__linux__)
+        if (fd >= 0)
+        {
+            ioctl(fd, PERF_EVENT_IOC_DISABLE, 0);
+            if (read(fd, &count, sizeof(count)) != sizeof(count))
+                count = 0;
+        }
+#endif
+        return count;
+    }
+
+private:
+    int fd;
+};
+
+// reference cycles when the cycle counter cannot be opened
+static uint64_t ReadTimestamp()
+{
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64)
+    return __rdtsc();
+#else
+    return static_cast<uint64_t>(std::chrono::steady_clock::now().time_since_epoch().count());
+#endif
+}
+
+/*
+    Series generators
+*/
+
+struct Series
+{
+    std::string name;
+    std::vector<uint64_t> values;
+};
+
+// values of exactly the given bit-width, so every word uses that width's selector
+static std::vector<uint64_t> MakeWidth(uint64_t length, uint32_t numBits, std::mt19937_64 &rng)
+{
+    std::vector<uint64_t> values(length);
+    for (uint64_t &v : values)
+        v = (numBits == 0) ? 0 : ((rng() & ((~0ULL) >> (64 - numBits))) | (1ULL << (numBits - 1)));
+    return values;
+}
+
+// microsecond timestamps with jittered ~1s spacing, for the fused delta + zigzag codec
+// (nanosecond epochs do not fit: the first value's zigzag is above 2^60)
+static std::vector<int64_t> MakeTimestamps(uint64_t length, std::mt19937_64 &rng)
+{
+    std::vector<int64_t> values(length);
+    int64_t t = 1700000000000000LL;
+    for (int64_t &v : values)
+    {
+        t += 1000000LL + static_cast<int64_t>(rng() % 2001) - 1000;
+        v = t;
+    }
+    return values;
+}
+
+// monotonically increasing counter with bursty increments, delta coded
+static std::vector<uint64_t> MakeCounterDeltas(uint64_t length, std::mt19937_64 &rng)
+{
+    std::vector<uint64_t> values(length);
+    for (uint64_t &v : values)
+        v = (rng() % 10 == 0) ? rng() % 5000 : rng() % 20;
+    return values;
+}
+
+// sensor readings as floats scaled to fixed point, zigzag'd deltas of a random walk
+static std::vector<uint64_t> MakeScaledFloats(uint64_t length, std::mt19937_64 &rng)
+{
+    std::vector<uint64_t> values(length);
+    std::normal_distribution<double> noise(0.0, 0.5);
+    double reading = 20.0;
+    int64_t previous = 0;
+    for (uint64_t &v : values)
+    {
+        reading += noise(rng);
+        const int64_t fixed = static_cast<int64_t>(std::llround(reading * 100.0));
+        const int64_t delta = fixed - previous;
+        previous = fixed;
+        v = (static_cast<uint64_t>(delta) << 1) ^ static_cast<uint64_t>(delta >> 63);
+    }
+    return values;
+}
+
+// runs of zeros broken by occasional small values
+static std::vector<uint64_t> MakeSparse(uint64_t length, std::mt19937_64 &rng)
+{
+    std::vector<uint64_t> values(length);
+    for (uint64_t &v : values)
+        v = (rng() % 500 == 0) ? rng() % 100 : 0;
+    return values;
+}
+
+/*
+    Harness
+*/
+
+struct Options
+{
+    std::string filter;
+    double minTime = 0.2;
+    std::string json;
+};
+
+struct Result
+{
+    std::string name;
+    uint64_t numValues;
+    double valuesPerSecond;
+    double bytesPerValue;
+    double cyclesPerValue;
+    double branchMissesPerValue; // negative when the counter is unavailable
+};
+
+class Bench
+{
+public:
+    explicit Bench(const Options &options)
+        : options(options), cycles(PERF_COUNT_HW_CPU_CYCLES), branchMisses(PERF_COUNT_HW_BRANCH_MISSES)
+    {
+    }
+
+    // times run() (one pass over numValues values) until minTime has elapsed
+    template <typename F>
+    void Run(const std::string &name, uint64_t numValues, uint64_t numWords, F run)
+    {
+        if (!options.filter.empty() && name.find(options.filter) == std::string::npos)
+            return;
+
+        run(); // warm caches and page in the buffers
+        uint64_t numRuns = 0;
+        uint64_t numCycles = 0;
+        uint64_t numMisses = 0;
+        double elapsed = 0;
+        while (elapsed < options.minTime)
+        {
+            const uint64_t tsc = ReadTimestamp();
+            cycles.Start();
+            branchMisses.Start();
+            const auto start = std::chrono::steady_clock::now();
+            run();
+            const auto stop = std::chrono::steady_clock::now();
+            numMisses += branchMisses.Stop();
+            const uint64_t counted = cycles.Stop();
+            numCycles += cycles.Available() ? counted : ReadTimestamp() - tsc;
+            elapsed += std::chrono::duration<double>(stop - start).count();
+            numRuns++;
+        }
+
+        const double total = static_cast<double>(numValues) * static_cast<double>(numRuns);
+        Result result;
+        result.name = name;
+        result.numValues = numValues;
+        result.valuesPerSecond = total / elapsed;
+        result.bytesPerValue = numValues ? 8.0 * static_cast<double>(numWords) / static_cast<double>(numValues) : 0;
+        result.cyclesPerValue = static_cast<double>(numCycles) / total;
+        result.branchMissesPerValue = branchMisses.Available() ? static_cast<double>(numMisses) / total : -1;
+        results.push_back(result);
+
+        printf("%-44s %10.1f Mv/s %7.3f B/v %8.3f cyc/v", name.c_str(), result.valuesPerSecond / 1e6,
+               result.bytesPerValue, result.cyclesPerValue);
+        if (result.branchMissesPerValue >= 0)
+            printf(" %8.4f miss/v", result.branchMissesPerValue);
+        printf("\n");
+    }
+
+    bool WriteJson() const
+    {
+        if (options.json.empty())
+            return true;
+        FILE *file = fopen(options.json.c_str(), "w");
+        if (file == NULL)
+            return false;
+        fprintf(file, "{\n  \"simd_level\": %d,\n  \"benchmarks\": [\n", static_cast<int>(Simple8bGetSimdLevel()));
+        for (size_t i = 0; i < results.size(); i++)
+        {
+            const Result &r = results[i];
+            fprintf(file,
+                    "    {\"name\": \"%s\", \"values\": %llu, \"values_per_second\": %.1f, \"bytes_per_value\": %.4f, "
+                    "\"cycles_per_value\": %.4f, \"branch_misses_per_value\": %.5f}%s\n",
+                    r.name.c_str(), static_cast<unsigned long long>(r.numValues), r.valuesPerSecond, r.bytesPerValue,
+                    r.cyclesPerValue, r.branchMissesPerValue, (i + 1 < results.size()) ? "," : "");
+        }
+        fprintf(file, "  ]\n}\n");
+        return fclose(file) == 0;
+    }
+
+private:
+    Options options;
+    Counter cycles;
+    Counter branchMisses;
+    std::vector<Result> results;
+};
+
+// encode and decode cases for one unsigned series
+static void BenchSeries(Bench &bench, const Series &series)
+{
+    const std::vector<uint64_t> &values = series.values;
+    const uint64_t length = values.size();
+    std::vector<uint64_t> words(Simple8bMaxCompressedSize(length) + 1);
+    std::vector<uint64_t> decoded(length + 1);
+    std::vector<uint64_t> input(values);
+    const uint64_t numWords = Simple8bEncode(input.data(), length, words.data());
+
+    bench.Run("encode/" + series.name, length, numWords, [&]
+              { Simple8bEncode(input.data(), length, words.data()); });
+    bench.Run("encode_cascade/" + series.name, length, numWords, [&]
+              { Simple8bEncodeCascade(input.data(), length, words.data()); });
+    bench.Run("encode_prescan/" + series.name, length, numWords, [&]
+              { Simple8bEncodePrescan(input.data(), length, words.data()); });
+    bench.Run("encode_profiled/" + series.name, length, numWords, [&]
+              { Simple8bEncodeProfiled(input.data(), length, words.data()); });
+    Simple8bEncode(input.data(), length, words.data());
+    bench.Run("decode/" + series.name, length, numWords, [&]
+              { Simple8bDecode(words.data(), length, decoded.data()); });
+    bench.Run("decode_table/" + series.name, length, numWords, [&]
+              { Simple8bDecodeTable(words.data(), length, decoded.data()); });
+
+    // a threshold half way up the widest value, against decoding and comparing
+    const uint64_t threshold = *std::max_element(values.begin(), values.end()) / 2;
+    std::vector<uint64_t> bitmap((length + 63) / 64);
+    bench.Run("filter_greater/" + series.name, length, numWords, [&]
+              { Simple8bFilterGreater(words.data(), length, threshold, bitmap.data()); });
+    bench.Run("decode_compare/" + series.name, length, numWords, [&]
+              {
+                  Simple8bDecode(words.data(), length, decoded.data());
+                  std::fill(bitmap.begin(), bitmap.end(), 0);
+                  for (uint64_t i = 0; i < length; i++)
+                      bitmap[i / 64] |= static_cast<uint64_t>(decoded[i] > threshold) << (i % 64);
+              });
+
+    std::vector<uint64_t> adaptiveWords(Simple8bAdaptiveMaxCompressedSize(length));
+    const uint64_t numAdaptiveWords = Simple8bAdaptiveEncode(values.data(), length, adaptiveWords.data());
+    bench.Run("adaptive_encode/" + series.name, length, numAdaptiveWords, [&]
+              { Simple8bAdaptiveEncode(values.data(), length, adaptiveWords.data()); });
+    bench.Run("adaptive_decode/" + series.name, length, numAdaptiveWords, [&]
+              { Simple8bAdaptiveDecode(adaptiveWords.data(), length, decoded.data()); });
+}
+
+static bool ParseOptions(int argc, char **argv, Options &options)
+{
+    for (int i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "--filter") == 0 && i + 1 < argc)
+            options.filter = argv[++i];
+        else if (strcmp(argv[i], "--min-time") == 0 && i + 1 < argc)
+            options.minTime = atof(argv[++i]);
+        else if (strcmp(argv[i], "--json") == 0 && i + 1 < argc)
+            options.json = argv[++i];
+        else
+            return false;
+    }
+    return true;
+}
+
+int main(int argc, char **argv)
+{
+    Options options;
+    if (!ParseOptions(argc, argv, options))
+    {
+        fprintf(stderr, "usage: %s [--filter substring] [--min-time seconds] [--json file]\n", argv[0]);
+        return 2;
+    }
+
+    Bench bench(options);
+    std::mt19937_64 rng(42);
+    const uint64_t length = 1 << 20;
+
+    for (uint32_t numBits : {0U, 1U, 2U, 3U, 4U, 5U, 6U, 7U, 8U, 9U, 10U, 12U, 13U, 15U, 20U, 30U, 60U})
+        BenchSeries(bench, {"width" + std::to_string(numBits), MakeWidth(length, numBits, rng)});
+    BenchSeries(bench, {"sparse_zeros", MakeSparse(length, rng)});
+    BenchSeries(bench, {"counter_deltas", MakeCounterDeltas(length, rng)});
+    BenchSeries(bench, {"scaled_floats", MakeScaledFloats(length, rng)});
+
+    // short inputs stay below 240 values left, ie in the careful path only
+    for (uint64_t shortLength : {1ULL, 7ULL, 60ULL, 239ULL, 1000ULL, 100000ULL})
+        BenchSeries(bench, {"counter_deltas/n" + std::to_string(shortLength), MakeCounterDeltas(shortLength, rng)});
+
+    // many short series: one call per series against one batch call over the same arena, its
+    // scratch reused through a context
+    const uint64_t numSeries = 50000;
+    const uint64_t seriesLength = 100;
+    const std::vector<uint64_t> batchValues = MakeCounterDeltas(numSeries * seriesLength, rng);
+    std::vector<const uint64_t *> batchInputs(numSeries);
+    std::vector<uint64_t> batchLengths(numSeries, seriesLength);
+    for (uint64_t i = 0; i < numSeries; i++)
+        batchInputs[i] = batchValues.data() + i * seriesLength;
+    std::vector<uint64_t> batchWords(Simple8bMaxCompressedSize(batchValues.size()));
+    std::vector<uint64_t> batchOffsets(numSeries + 1);
+    std::vector<uint64_t> batchDecoded(batchValues.size());
+    Simple8bContext batchContext;
+    const uint64_t numBatchWords = Simple8bEncodeBatch(batchInputs.data(), batchLengths.data(), numSeries,
+                                                       batchWords.data(), batchOffsets.data());
+    const std::string batchName = std::to_string(numSeries) + "x" + std::to_string(seriesLength);
+    bench.Run("encode_series_loop/" + batchName, batchValues.size(), numBatchWords, [&]
+              {
+                  uint64_t offset = 0;
+                  for (uint64_t i = 0; i < numSeries; i++)
+                  {
+                      batchOffsets[i] = offset;
+                      offset += Simple8bEncode(batchInputs[i], seriesLength, batchWords.data() + offset);
+                  }
+                  batchOffsets[numSeries] = offset;
+              });
+    bench.Run("encode_batch/" + batchName, batchValues.size(), numBatchWords, [&]
+              { Simple8bEncodeBatch(batchInputs.data(), batchLengths.data(), numSeries, batchWords.data(),
+                                    batchOffsets.data(), 1, &batchContext); });
+    bench.Run("decode_series_loop/" + batchName, batchValues.size(), numBatchWords, [&]
+              {
+                  for (uint64_t i = 0; i < numSeries; i++)
+                      Simple8bDecode(batchWords.data() + batchOffsets[i], seriesLength,
+                                     batchDecoded.data() + i * seriesLength);
+              });
+    bench.Run("decode_batch/" + batchName, batchValues.size(), numBatchWords, [&]
+              { Simple8bDecodeBatch(batchWords.data(), batchOffsets.data(), batchLengths.data(), numSeries,
+                                    batchDecoded.data(), 1, &batchContext); });
+
+    // timestamps go through the fused delta + zigzag codec
+    const std::vector<int64_t> timestamps = MakeTimestamps(length, rng);
+    std::vector<uint64_t> words(Simple8bMaxCompressedSize(length) + 1);
+    std::vector<int64_t> decoded(length);
+    const uint64_t numWords = Simple8bDeltaZigZagEncode(timestamps.data(), length, words.data());
+    bench.Run("delta_zigzag_encode/timestamps_us", length, numWords, [&]
+              { Simple8bDeltaZigZagEncode(timestamps.data(), length, words.data()); });
+    bench.Run("delta_zigzag_decode/timestamps_us", length, numWords, [&]
+              { Simple8bDeltaZigZagDecode(words.data(), length, decoded.data()); });
+
+    const uint64_t numDodWords = Simple8bDeltaOfDeltaEncode(timestamps.data(), length, words.data());
+    bench.Run("delta_of_delta_encode/timestamps_us", length, numDodWords, [&]
+              { Simple8bDeltaOfDeltaEncode(timestamps.data(), length, words.data()); });
+    bench.Run("delta_of_delta_decode/timestamps_us", length, numDodWords, [&]
+              { Simple8bDeltaOfDeltaDecode(words.data(), length, decoded.data()); });
+
+    // on-disk container: a narrow time range only decodes the blocks its min/max can hold
+    const std::vector<uint64_t> rawTimestamps(timestamps.begin(), timestamps.end());
+    std::vector<uint64_t> fileWords(Simple8bFileMaxWords(length, 4096));
+    const uint64_t numFileWords = Simple8bFileEncode(rawTimestamps.data(), length, 4096, fileWords.data());
+    Simple8bFileReader reader;
+    reader.Attach(fileWords.data(), numFileWords);
+    std::vector<uint64_t> selected(length);
+    std::vector<uint64_t> positions(length);
+    bench.Run("file_decode/timestamps_us", length, numFileWords, [&]
+              { reader.Decode(selected.data()); });
+    bench.Run("file_select_1pct/timestamps_us", length, numFileWords, [&]
+              { reader.Select(rawTimestamps[length / 2], rawTimestamps[length / 2 + length / 100], selected.data(),
+                              positions.data()); });
+
+#if defined(SIMPLE8B_MMAP)
+    // the same container read from a file: block by block, reading then decoding in turn, and
+    // pipelined, decoding blocks while the next ones are read (from the page cache here, so this
+    // times the overlap of the read calls with decoding rather than the device)
+    const std::string filePath = "simple8b_bench.s8b";
+    FILE *file = fopen(filePath.c_str(), "wb");
+    const bool written = file != NULL && fwrite(fileWords.data(), sizeof(uint64_t), numFileWords, file) == numFileWords;
+    if (file != NULL)
+        fclose(file);
+    Simple8bFilePipeline pipeline;
+    if (written && pipeline.Open(filePath.c_str()))
+    {
+        const int fd = open(filePath.c_str(), O_RDONLY);
+        std::vector<uint64_t> blockWords(numFileWords);
+        bench.Run("file_read_decode/timestamps_us", length, numFileWords, [&]
+                  {
+                      for (uint64_t i = 0; i < reader.NumBlocks(); i++)
+                      {
+                          const Simple8bFileBlock block = reader.Block(i);
+                          const uint64_t end = (i + 1 < reader.NumBlocks()) ? reader.Block(i + 1).offset : numFileWords;
+                          if (pread(fd, blockWords.data(), (end - block.offset) * sizeof(uint64_t),
+                                    static_cast<off_t>(block.offset * sizeof(uint64_t))) < 0)
+                              break;
+                          Simple8bDecode(blockWords.data(), block.numValues, selected.data() + reader.BlockStart(i));
+                      }
+                  });
+        bench.Run("file_pipeline_decode/timestamps_us", length, numFileWords, [&]
+                  {
+                      pipeline.Decode<uint64_t>([&](uint64_t i, const uint64_t *values, uint64_t numValues)
+                                                { std::copy(values, values + numValues, selected.data() + pipeline.BlockStart(i)); });
+                  });
+        close(fd);
+    }
+    remove(filePath.c_str());
+#endif
+
+    // 100 series scraped together: separate delta-of-delta + delta-zigzag streams per series,
+    // against one columnar block storing the shared timestamps once
+    const uint64_t numColumnSeries = 100;
+    const uint64_t columnLength = 10000;
+    const std::vector<int64_t> scrapeTimes = MakeTimestamps(columnLength, rng);
+    std::vector<std::vector<int64_t>> gauges(numColumnSeries, std::vector<int64_t>(columnLength));
+    std::vector<const int64_t *> seriesTimes(numColumnSeries, scrapeTimes.data());
+    std::vector<const int64_t *> seriesValues(numColumnSeries);
+    const std::vector<uint64_t> columnLengths(numColumnSeries, columnLength);
+    for (uint64_t i = 0; i < numColumnSeries; i++)
+    {
+        int64_t gauge = 0;
+        for (int64_t &v : gauges[i])
+            v = gauge += static_cast<int64_t>(rng() % 201) - 100;
+        seriesValues[i] = gauges[i].data();
+    }
+    const uint64_t numPairs = numColumnSeries * columnLength;
+    std::vector<uint64_t> pairWords(2 * numPairs);
+    std::vector<uint64_t> pairOffsets(2 * numColumnSeries + 1);
+    std::vector<int64_t> decodedTimes(numPairs);
+    std::vector<int64_t> decodedValues(numPairs);
+    const auto encodePairs = [&]
+    {
+        uint64_t offset = 0;
+        for (uint64_t i = 0; i < numColumnSeries; i++)
+        {
+            pairOffsets[2 * i] = offset;
+            offset += Simple8bDeltaOfDeltaEncode(seriesTimes[i], columnLength, pairWords.data() + offset);
+            pairOffsets[2 * i + 1] = offset;
+            offset += Simple8bDeltaZigZagEncode(seriesValues[i], columnLength, pairWords.data() + offset);
+        }
+        return offset;
+    };
+    const uint64_t numPairWords = encodePairs();
+    bench.Run("pairs_encode/shared_timestamps", numPairs, numPairWords, [&]
+              { encodePairs(); });
+    bench.Run("pairs_decode/shared_timestamps", numPairs, numPairWords, [&]
+              {
+                  for (uint64_t i = 0; i < numColumnSeries; i++)
+                  {
+                      Simple8bDeltaOfDeltaDecode(pairWords.data() + pairOffsets[2 * i], columnLength,
+                                                 decodedTimes.data() + i * columnLength);
+                      Simple8bDeltaZigZagDecode(pairWords.data() + pairOffsets[2 * i + 1], columnLength,
+                                                decodedValues.data() + i * columnLength);
+                  }
+              });
+
+    std::vector<uint64_t> columnWords(Simple8bColumnsMaxWords(columnLengths.data(), numColumnSeries));
+    const uint64_t numColumnWords = Simple8bColumnsEncode(seriesTimes.data(), seriesValues.data(), columnLengths.data(),
+                                                          numColumnSeries, columnWords.data());
+    Simple8bColumnsReader columns;
+    columns.Attach(columnWords.data(), numColumnWords);
+    int64_t *const timeColumn = decodedTimes.data();
+    std::vector<int64_t *> valueColumns(numColumnSeries);
+    for (uint64_t i = 0; i < numColumnSeries; i++)
+        valueColumns[i] = decodedValues.data() + i * columnLength;
+    Simple8bContext columnContext;
+    bench.Run("columns_encode/shared_timestamps", numPairs, numColumnWords, [&]
+              { Simple8bColumnsEncode(seriesTimes.data(), seriesValues.data(), columnLengths.data(), numColumnSeries,
+                                      columnWords.data()); });
+    bench.Run("columns_decode/shared_timestamps", numPairs, numColumnWords, [&]
+              { columns.Decode(&timeColumn, valueColumns.data(), 1, &columnContext); });
+    bench.Run("columns_decode_threads/shared_timestamps", numPairs, numColumnWords, [&]
+              { columns.Decode(&timeColumn, valueColumns.data(), 0, &columnContext); });
+
+    // the delta transforms alone, out of place so every run sees the same input
+    std::vector<int64_t> deltas(length);
+    bench.Run("delta_encode/timestamps_us", length, 0, [&]
+              { DeltaEncode(timestamps.data(), length, deltas.data()); });
+    bench.Run("delta_decode/timestamps_us", length, 0, [&]
+              { DeltaDecode(deltas.data(), length, decoded.data()); });
+
+    if (!bench.WriteJson())
+    {
+        fprintf(stderr, "cannot write %s\n", options.json.c_str());
+        return 1;
+    }
+    return 0;
+}
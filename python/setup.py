@@ -0,0 +1,21 @@
+# builds the simple8b extension module in place: python setup.py build_ext --inplace
+import os
+
+from setuptools import Extension, setup
+
+ROOT = os.path.join(os.path.dirname(os.path.abspath(__file__)), "..")
+
+setup(
+    name="simple8b",
+    version="0.1.0",
+    description="Simple8b integer compression over NumPy / buffer-protocol arrays",
+    ext_modules=[
+        Extension(
+            "simple8b",
+            sources=["simple8bmodule.cpp", os.path.relpath(os.path.join(ROOT, "simple8b.cpp"))],
+            include_dirs=[ROOT],
+            language="c++",
+            extra_compile_args=["/O2"] if os.name == "nt" else ["-O3", "-std=c++17"],
+        )
+    ],
+)
@@ -0,0 +1,485 @@
+/*
+    CPython extension over the C ABI in simple8b.h.
+
+    Arrays go in and out through the buffer protocol, so NumPy arrays (or array.array, bytearray,
+    memoryview...) are read in place and results come back as memoryviews that np.asarray wraps
+    without copying. The GIL is released while the codec runs.
+
+        words = simple8b.encode(values)                  # memoryview of uint64 words
+        values = simple8b.decode(words, n, "q")          # memoryview of n int64 values
+        simple8b.decode(words, n, out=array)             # or straight into an existing array
+        streams = simple8b.encode_batch([a, b, c])       # one call, one GIL release
+*/
+
+#define PY_SSIZE_T_CLEAN
+#include <Python.h>
+
+#include "simple8b.h"
+
+#include <vector>
+
+// element types in the order of the SIMPLE8B_* entry point tables below
+enum ElementType
+{
+    ELEMENT_U8,
+    ELEMENT_U16,
+    ELEMENT_U32,
+    ELEMENT_U64,
+    ELEMENT_I8,
+    ELEMENT_I16,
+    ELEMENT_I32,
+    ELEMENT_I64,
+    ELEMENT_INVALID
+};
+
+typedef uint64_t (*EncodeFunction)(const void *, uint64_t, uint64_t *, uint64_t);
+typedef uint64_t (*DecodeFunction)(const uint64_t *, uint64_t, uint64_t, void *);
+typedef void (*TransformFunction)(void *, uint64_t);
+
+// adapters from the typed C entry points to the untyped tables below
+template <typename T, uint64_t (*F)(const T *, uint64_t, uint64_t *, uint64_t)>
+static uint64_t EncodeAs(const void *input, uint64_t inputLength, uint64_t *output, uint64_t outputCapacity)
+{
+    return F(static_cast<const T *>(input), inputLength, output, outputCapacity);
+}
+
+template <typename T, uint64_t (*F)(const uint64_t *, uint64_t, uint64_t, T *)>
+static uint64_t DecodeAs(const uint64_t *input, uint64_t inputWords, uint64_t outputLength, void *output)
+{
+    return F(input, inputWords, outputLength, static_cast<T *>(output));
+}
+
+template <typename T, void (*F)(T *, uint64_t)>
+static void TransformAs(void *input, uint64_t length)
+{
+    F(static_cast<T *>(input), length);
+}
+
+static const Py_ssize_t ITEMSIZE[8] = {1, 2, 4, 8, 1, 2, 4, 8};
+
+// signed arrays are encoded as their bit patterns, so zigzag_encode output (and any int8-int32
+// array) round-trips; a negative int64 still does not fit a word
+static const EncodeFunction ENCODE[8] = {
+    EncodeAs<uint8_t, Simple8bEncodeCheckedU8>, EncodeAs<uint16_t, Simple8bEncodeCheckedU16>,
+    EncodeAs<uint32_t, Simple8bEncodeCheckedU32>, EncodeAs<uint64_t, Simple8bEncodeCheckedU64>,
+    EncodeAs<uint8_t, Simple8bEncodeCheckedU8>, EncodeAs<uint16_t, Simple8bEncodeCheckedU16>,
+    EncodeAs<uint32_t, Simple8bEncodeCheckedU32>, EncodeAs<uint64_t, Simple8bEncodeCheckedU64>};
+
+static const DecodeFunction DECODE[8] = {
+    DecodeAs<uint8_t, Simple8bDecodeCheckedU8>, DecodeAs<uint16_t, Simple8bDecodeCheckedU16>,
+    DecodeAs<uint32_t, Simple8bDecodeCheckedU32>, DecodeAs<uint64_t, Simple8bDecodeCheckedU64>,
+    DecodeAs<int8_t, Simple8bDecodeCheckedI8>, DecodeAs<int16_t, Simple8bDecodeCheckedI16>,
+    DecodeAs<int32_t, Simple8bDecodeCheckedI32>, DecodeAs<int64_t, Simple8bDecodeCheckedI64>};
+
+// signed types only, indexed by ElementType - ELEMENT_I8
+static const TransformFunction DELTA_ENCODE[4] = {
+    TransformAs<int8_t, DeltaEncodeI8>, TransformAs<int16_t, DeltaEncodeI16>,
+    TransformAs<int32_t, DeltaEncodeI32>, TransformAs<int64_t, DeltaEncodeI64>};
+static const TransformFunction DELTA_DECODE[4] = {
+    TransformAs<int8_t, DeltaDecodeI8>, TransformAs<int16_t, DeltaDecodeI16>,
+    TransformAs<int32_t, DeltaDecodeI32>, TransformAs<int64_t, DeltaDecodeI64>};
+static const TransformFunction ZIGZAG_ENCODE[4] = {
+    TransformAs<int8_t, ZigZagEncodeI8>, TransformAs<int16_t, ZigZagEncodeI16>,
+    TransformAs<int32_t, ZigZagEncodeI32>, TransformAs<int64_t, ZigZagEncodeI64>};
+static const TransformFunction ZIGZAG_DECODE[4] = {
+    TransformAs<int8_t, ZigZagDecodeI8>, TransformAs<int16_t, ZigZagDecodeI16>,
+    TransformAs<int32_t, ZigZagDecodeI32>, TransformAs<int64_t, ZigZagDecodeI64>};
+
+// native size of a struct module integer format character, 0 if it is not one
+static Py_ssize_t GetNativeItemSize(char format)
+{
+    switch (format)
+    {
+    case 'b':
+    case 'B':
+        return 1;
+    case 'h':
+    case 'H':
+        return sizeof(short);
+    case 'i':
+    case 'I':
+        return sizeof(int);
+    case 'l':
+    case 'L':
+        return sizeof(long);
+    case 'q':
+    case 'Q':
+        return sizeof(long long);
+    case 'n':
+    case 'N':
+        return sizeof(Py_ssize_t);
+    default:
+        return 0;
+    }
+}
+
+// struct module format character of a native integer ('@' or '=' prefix allowed), sized by
+// itemsize, or by its native size when itemsize is 0
+static ElementType GetElementType(const char *format, Py_ssize_t itemsize)
+{
+    if (format == NULL)
+        format = "B";
+    if (format[0] == '@' || format[0] == '=')
+        format++;
+    if (format[0] == '\0' || format[1] != '\0')
+        return ELEMENT_INVALID;
+    if (itemsize == 0)
+        itemsize = GetNativeItemSize(format[0]);
+
+    bool isSigned;
+    switch (format[0])
+    {
+    case 'b':
+    case 'h':
+    case 'i':
+    case 'l':
+    case 'q':
+    case 'n':
+        isSigned = true;
+        break;
+    case 'B':
+    case 'H':
+    case 'I':
+    case 'L':
+    case 'Q':
+    case 'N':
+        isSigned = false;
+        break;
+    default:
+        return ELEMENT_INVALID;
+    }
+
+    switch (itemsize)
+    {
+    case 1:
+        return isSigned ? ELEMENT_I8 : ELEMENT_U8;
+    case 2:
+        return isSigned ? ELEMENT_I16 : ELEMENT_U16;
+    case 4:
+        return isSigned ? ELEMENT_I32 : ELEMENT_U32;
+    case 8:
+        return isSigned ? ELEMENT_I64 : ELEMENT_U64;
+    default:
+        return ELEMENT_INVALID;
+    }
+}
+
+// contiguous buffer of native integers; sets a Python error and returns false otherwise
+static bool GetIntegerBuffer(PyObject *object, Py_buffer *view, int flags, ElementType *type)
+{
+    if (PyObject_GetBuffer(object, view, flags | PyBUF_FORMAT | PyBUF_C_CONTIGUOUS) != 0)
+        return false;
+    *type = GetElementType(view->format, view->itemsize);
+    if (*type == ELEMENT_INVALID)
+    {
+        PyErr_Format(PyExc_TypeError, "expected a buffer of native integers, got format '%s'",
+                     view->format ? view->format : "B");
+        PyBuffer_Release(view);
+        return false;
+    }
+    return true;
+}
+
+static bool SetCodecError(uint64_t result)
+{
+    if (result == SIMPLE8B_ERROR_VALUE_TOO_LARGE)
+        PyErr_SetString(PyExc_ValueError, "value does not fit in 60 bits (or is negative)");
+    else if (result == SIMPLE8B_ERROR_OUTPUT_TOO_SMALL)
+        PyErr_SetString(PyExc_ValueError, "output buffer too small");
+    else if (result == SIMPLE8B_ERROR_INPUT_TRUNCATED)
+        PyErr_SetString(PyExc_ValueError, "compressed stream ends before the requested number of values");
+    else
+        return false;
+    return true;
+}
+
+// typed memoryview over bytes, which it takes over
+static PyObject *ViewAs(PyObject *bytes, const char *format)
+{
+    if (bytes == NULL)
+        return NULL;
+    PyObject *view = PyMemoryView_FromObject(bytes);
+    Py_DECREF(bytes);
+    if (view == NULL)
+        return NULL;
+    PyObject *typed = PyObject_CallMethod(view, "cast", "s", format);
+    Py_DECREF(view);
+    return typed;
+}
+
+// bytearray sized for the worst case of numValues values, to encode straight into; trimmed
+// to the words written by FinishWords
+static PyObject *NewWords(uint64_t numValues)
+{
+    return PyByteArray_FromStringAndSize(NULL, static_cast<Py_ssize_t>(Simple8bMaxCompressedSize(numValues) *
+                                                                       sizeof(uint64_t)));
+}
+
+static PyObject *FinishWords(PyObject *bytes, uint64_t numWords)
+{
+    if (PyByteArray_Resize(bytes, static_cast<Py_ssize_t>(numWords * sizeof(uint64_t))) != 0)
+    {
+        Py_DECREF(bytes);
+        return NULL;
+    }
+    return ViewAs(bytes, "Q");
+}
+
+static uint64_t *GetWords(PyObject *bytes)
+{
+    return reinterpret_cast<uint64_t *>(PyByteArray_AS_STRING(bytes));
+}
+
+static PyObject *Encode(PyObject *self, PyObject *args, PyObject *kwargs)
+{
+    static const char *keywords[] = {"values", "out", NULL};
+    PyObject *valuesObject;
+    PyObject *outObject = Py_None;
+    if (!PyArg_ParseTupleAndKeywords(args, kwargs, "O|O:encode", const_cast<char **>(keywords), &valuesObject,
+                                     &outObject))
+        return NULL;
+
+    Py_buffer values;
+    ElementType type;
+    if (!GetIntegerBuffer(valuesObject, &values, PyBUF_SIMPLE, &type))
+        return NULL;
+    const uint64_t numValues = static_cast<uint64_t>(values.len / values.itemsize);
+
+    // with out given, encode in place and return the number of words written
+    if (outObject != Py_None)
+    {
+        Py_buffer out;
+        if (PyObject_GetBuffer(outObject, &out, PyBUF_WRITABLE | PyBUF_C_CONTIGUOUS) != 0)
+        {
+            PyBuffer_Release(&values);
+            return NULL;
+        }
+        uint64_t result;
+        Py_BEGIN_ALLOW_THREADS;
+        result = ENCODE[type](values.buf, numValues, static_cast<uint64_t *>(out.buf),
+                              static_cast<uint64_t>(out.len) / sizeof(uint64_t));
+        Py_END_ALLOW_THREADS;
+        PyBuffer_Release(&out);
+        PyBuffer_Release(&values);
+        if (SetCodecError(result))
+            return NULL;
+        return PyLong_FromUnsignedLongLong(result);
+    }
+
+    PyObject *words = NewWords(numValues);
+    if (words == NULL)
+    {
+        PyBuffer_Release(&values);
+        return NULL;
+    }
+    uint64_t result;
+    Py_BEGIN_ALLOW_THREADS;
+    result = ENCODE[type](values.buf, numValues, GetWords(words), Simple8bMaxCompressedSize(numValues));
+    Py_END_ALLOW_THREADS;
+    PyBuffer_Release(&values);
+    if (SetCodecError(result))
+    {
+        Py_DECREF(words);
+        return NULL;
+    }
+    return FinishWords(words, result);
+}
+
+static PyObject *EncodeBatch(PyObject *self, PyObject *args)
+{
+    PyObject *sequenceObject;
+    if (!PyArg_ParseTuple(args, "O:encode_batch", &sequenceObject))
+        return NULL;
+    PyObject *sequence = PySequence_Fast(sequenceObject, "encode_batch expects a sequence of arrays");
+    if (sequence == NULL)
+        return NULL;
+
+    const Py_ssize_t numArrays = PySequence_Fast_GET_SIZE(sequence);
+    std::vector<Py_buffer> values(numArrays);
+    std::vector<ElementType> types(numArrays);
+    std::vector<uint64_t> lengths(numArrays);
+    std::vector<uint64_t> results(numArrays);
+    PyObject *streams = PyList_New(numArrays);
+    Py_ssize_t numAcquired = 0;
+    if (streams == NULL)
+        goto done;
+
+    for (; numAcquired < numArrays; numAcquired++)
+    {
+        if (!GetIntegerBuffer(PySequence_Fast_GET_ITEM(sequence, numAcquired), &values[numAcquired], PyBUF_SIMPLE,
+                              &types[numAcquired]))
+            goto fail;
+        lengths[numAcquired] = static_cast<uint64_t>(values[numAcquired].len / values[numAcquired].itemsize);
+        PyObject *words = NewWords(lengths[numAcquired]);
+        if (words == NULL)
+        {
+            PyBuffer_Release(&values[numAcquired]);
+            goto fail;
+        }
+        PyList_SET_ITEM(streams, numAcquired, words);
+    }
+
+    Py_BEGIN_ALLOW_THREADS;
+    for (Py_ssize_t i = 0; i < numArrays; i++)
+        results[i] = ENCODE[types[i]](values[i].buf, lengths[i], GetWords(PyList_GET_ITEM(streams, i)),
+                                      Simple8bMaxCompressedSize(lengths[i]));
+    Py_END_ALLOW_THREADS;
+
+    for (Py_ssize_t i = 0; i < numArrays; i++)
+        if (SetCodecError(results[i]))
+            goto fail;
+
+    // swap each bytearray for its trimmed view
+    for (Py_ssize_t i = 0; i < numArrays; i++)
+    {
+        PyObject *words = PyList_GET_ITEM(streams, i);
+        Py_INCREF(words);
+        PyObject *view = FinishWords(words, results[i]);
+        if (view == NULL)
+            goto fail;
+        PyList_SetItem(streams, i, view);
+    }
+    goto done;
+
+fail:
+    Py_CLEAR(streams);
+done:
+    for (Py_ssize_t i = 0; i < numAcquired; i++)
+        PyBuffer_Release(&values[i]);
+    Py_DECREF(sequence);
+    return streams;
+}
+
+static PyObject *Decode(PyObject *self, PyObject *args, PyObject *kwargs)
+{
+    static const char *keywords[] = {"words", "length", "format", "out", NULL};
+    PyObject *wordsObject;
+    unsigned long long length;
+    const char *format = "Q";
+    PyObject *outObject = Py_None;
+    if (!PyArg_ParseTupleAndKeywords(args, kwargs, "OK|sO:decode", const_cast<char **>(keywords), &wordsObject,
+                                     &length, &format, &outObject))
+        return NULL;
+
+    Py_buffer words;
+    if (PyObject_GetBuffer(wordsObject, &words, PyBUF_C_CONTIGUOUS) != 0)
+        return NULL;
+    const uint64_t numWords = static_cast<uint64_t>(words.len) / sizeof(uint64_t);
+
+    PyObject *result = NULL;
+    Py_buffer out;
+    ElementType type;
+    char *data;
+    if (outObject != Py_None)
+    {
+        if (!GetIntegerBuffer(outObject, &out, PyBUF_WRITABLE, &type))
+            goto done;
+        if (static_cast<uint64_t>(out.len / out.itemsize) < length)
+        {
+            PyErr_SetString(PyExc_ValueError, "output buffer too small");
+            PyBuffer_Release(&out);
+            goto done;
+        }
+        data = static_cast<char *>(out.buf);
+        result = outObject;
+        Py_INCREF(result);
+    }
+    else
+    {
+        type = GetElementType(format, 0);
+        if (type == ELEMENT_INVALID)
+        {
+            PyErr_Format(PyExc_TypeError, "unsupported format '%s'", format);
+            goto done;
+        }
+        PyObject *bytes = PyByteArray_FromStringAndSize(NULL, static_cast<Py_ssize_t>(length) * ITEMSIZE[type]);
+        if (bytes == NULL)
+            goto done;
+        data = PyByteArray_AS_STRING(bytes);
+        result = ViewAs(bytes, format);
+        if (result == NULL)
+            goto done;
+    }
+
+    {
+        uint64_t decoded;
+        Py_BEGIN_ALLOW_THREADS;
+        decoded = DECODE[type](static_cast<const uint64_t *>(words.buf), numWords, length, data);
+        Py_END_ALLOW_THREADS;
+        if (outObject != Py_None)
+            PyBuffer_Release(&out);
+        if (SetCodecError(decoded))
+            Py_CLEAR(result);
+    }
+
+done:
+    PyBuffer_Release(&words);
+    return result;
+}
+
+// in-place transform of a writable buffer of signed integers
+static PyObject *Transform(PyObject *args, const char *format, const TransformFunction *functions)
+{
+    PyObject *valuesObject;
+    if (!PyArg_ParseTuple(args, format, &valuesObject))
+        return NULL;
+    Py_buffer values;
+    ElementType type;
+    if (!GetIntegerBuffer(valuesObject, &values, PyBUF_WRITABLE, &type))
+        return NULL;
+    if (type < ELEMENT_I8)
+    {
+        PyErr_SetString(PyExc_TypeError, "expected a buffer of signed integers");
+        PyBuffer_Release(&values);
+        return NULL;
+    }
+    Py_BEGIN_ALLOW_THREADS;
+    functions[type - ELEMENT_I8](values.buf, static_cast<uint64_t>(values.len / values.itemsize));
+    Py_END_ALLOW_THREADS;
+    PyBuffer_Release(&values);
+    Py_RETURN_NONE;
+}
+
+static PyObject *DeltaEncode(PyObject *self, PyObject *args)
+{
+    return Transform(args, "O:delta_encode", DELTA_ENCODE);
+}
+
+static PyObject *DeltaDecode(PyObject *self, PyObject *args)
+{
+    return Transform(args, "O:delta_decode", DELTA_DECODE);
+}
+
+static PyObject *ZigZagEncode(PyObject *self, PyObject *args)
+{
+    return Transform(args, "O:zigzag_encode", ZIGZAG_ENCODE);
+}
+
+static PyObject *ZigZagDecode(PyObject *self, PyObject *args)
+{
+    return Transform(args, "O:zigzag_decode", ZIGZAG_DECODE);
+}
+
+static PyMethodDef SIMPLE8B_METHODS[] = {
+    {"encode", reinterpret_cast<PyCFunction>(reinterpret_cast<void (*)(void)>(Encode)), METH_VARARGS | METH_KEYWORDS,
+     "encode(values, out=None)\n\nSimple8b-encodes a buffer of integers. Returns a memoryview of uint64 words, or "
+     "the number of words written when out is given."},
+    {"encode_batch", EncodeBatch, METH_VARARGS,
+     "encode_batch(arrays)\n\nEncodes every array of the sequence in one call; returns a list of word memoryviews."},
+    {"decode", reinterpret_cast<PyCFunction>(reinterpret_cast<void (*)(void)>(Decode)), METH_VARARGS | METH_KEYWORDS,
+     "decode(words, length, format='Q', out=None)\n\nDecodes length values. Returns a memoryview of that struct "
+     "format, or out (any writable integer buffer) filled in place."},
+    {"delta_encode", DeltaEncode, METH_VARARGS, "delta_encode(values)\n\nIn-place delta encoding of signed integers."},
+    {"delta_decode", DeltaDecode, METH_VARARGS, "delta_decode(values)\n\nIn-place inverse of delta_encode."},
+    {"zigzag_encode", ZigZagEncode, METH_VARARGS, "zigzag_encode(values)\n\nIn-place zigzag encoding of signed integers."},
+    {"zigzag_decode", ZigZagDecode, METH_VARARGS, "zigzag_decode(values)\n\nIn-place inverse of zigzag_encode."},
+    {NULL, NULL, 0, NULL}};
+
+static struct PyModuleDef SIMPLE8B_MODULE = {PyModuleDef_HEAD_INIT, "simple8b",
+                                             "Simple8b integer compression over buffer-protocol arrays.", -1,
+                                             SIMPLE8B_METHODS};
+
+PyMODINIT_FUNC PyInit_simple8b(void)
+{
+    return PyModule_Create(&SIMPLE8B_MODULE);
+}
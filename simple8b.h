@@ -1,23 +1,166 @@
-#ifdef __EMSCRIPTEN__
-#include <emscripten.h>
-#endif
-
-#if defined(_WIN32)
-#define EXPORT __declspec(dllexport) /* compile as a Win32 DLL (C#) */
-#elif defined(__EMSCRIPTEN__)
-#define EXPORT EMSCRIPTEN_KEEPALIVE /* compile as WebAssembly (JavaScript) */
-#else
-#define EXPORT /* compile as a shared library (eg for Python) */
-#endif
-
-extern "C" /* prevent compiler from mangling function names */
-{
-    EXPORT uint64_t Simple8bEncode<>(uint64_t *input, uint64_t inputLength, uint64_t *output);
-    EXPORT uint64_t Simple8bDecode<>(uint64_t *input, uint64_t outputLength, uint64_t *output);
-
-    EXPORT void DeltaEncode(int64_t *input, uint64_t length);
-    EXPORT void DeltaDecode(int64_t *input, uint64_t length);
-
-    EXPORT void ZigZagEncode(int64_t *input, uint64_t length);
-    EXPORT void ZigZagDecode(int64_t *input, uint64_t length);
-}
\ No newline at end of file
+#ifndef SIMPLE8B_H
+#define SIMPLE8B_H
+
+#include <stdint.h>
+
+#ifdef __EMSCRIPTEN__
+#include <emscripten.h>
+#endif
+
+#if defined(_WIN32)
+#define EXPORT __declspec(dllexport) /* compile as a Win32 DLL (C#) */
+#elif defined(__EMSCRIPTEN__)
+#define EXPORT EMSCRIPTEN_KEEPALIVE /* compile as WebAssembly (JavaScript) */
+#else
+#define EXPORT /* compile as a shared library (eg for Python) */
+#endif
+
+/* returned instead of a word count when the input holds a value above 2^60 - 1 (or a negative one) */
+#define SIMPLE8B_ERROR_VALUE_TOO_LARGE (~0ULL)
+
+/* returned by the capacity-checked entry points when the output buffer cannot hold the stream */
+#define SIMPLE8B_ERROR_OUTPUT_TOO_SMALL (~0ULL - 1)
+
+/* returned by the capacity-checked entry points when the input ends before the stream does */
+#define SIMPLE8B_ERROR_INPUT_TRUNCATED (~0ULL - 2)
+
+/* kernel sets available to the decoder, see Simple8bSetSimdLevel */
+typedef enum Simple8bSimdLevel
+{
+    SIMPLE8B_SIMD_SCALAR = 0,
+    SIMPLE8B_SIMD_NEON = 1,
+    SIMPLE8B_SIMD_AVX2 = 2,
+    SIMPLE8B_SIMD_AVX512 = 3,
+    SIMPLE8B_SIMD_WASM128 = 4
+} Simple8bSimdLevel;
+
+/*
+    Scratch memory and worker threads reused across calls, so the batch entry points make no heap
+    allocations once warmed up; NULL gives each call its own. One call at a time per context.
+*/
+typedef struct Simple8bContext Simple8bContext;
+
+/*
+    Counters kept per thread when the library is built with SIMPLE8B_STATS (see
+    Simple8bStatsGet); without it they stay zero. Encode counts Simple8bEncode and the fused
+    transform encoders, decode their inverses.
+*/
+typedef struct Simple8bCodecStats
+{
+    uint64_t calls;
+    uint64_t values;
+    uint64_t words;
+    uint64_t selectorWords[16]; /* words written or read per selector */
+    uint64_t wastedBits;        /* payload bits left unused by the packed words */
+    uint64_t carefulValues;     /* values through the careful loop over a stream's last words */
+} Simple8bCodecStats;
+
+typedef struct Simple8bStats
+{
+    Simple8bCodecStats encode;
+    Simple8bCodecStats decode;
+    /* time per phase, in TSC ticks on x86 and nanoseconds elsewhere; the fused encoders compute
+       delta and zigzag in one expression, counted as delta */
+    uint64_t deltaTicks;
+    uint64_t zigzagTicks;
+    uint64_t packTicks;
+    uint64_t unpackTicks;
+} Simple8bStats;
+
+/*
+    One set of entry points per element type, so narrow arrays go through the FFI as they are,
+    without widening them to uint64_t first. All lengths and sizes are counts of elements or of
+    uint64_t words.
+*/
+#define SIMPLE8B_DECLARE_TYPE(suffix, type)                                                                   \
+    EXPORT uint64_t Simple8bEncode##suffix(const type *input, uint64_t inputLength, uint64_t *output);        \
+    EXPORT uint64_t Simple8bDecode##suffix(uint64_t *input, uint64_t outputLength, type *output);             \
+    EXPORT uint64_t Simple8bEncodeChecked##suffix(const type *input, uint64_t inputLength, uint64_t *output, \
+                                                  uint64_t outputCapacity);                                  \
+    EXPORT uint64_t Simple8bDecodeChecked##suffix(const uint64_t *input, uint64_t inputWords,                \
+                                                  uint64_t outputLength, type *output);                       \
+    EXPORT uint64_t Simple8bFrameOfReferenceEncode##suffix(const type *input, uint64_t inputLength,           \
+                                                           uint64_t *output);                                 \
+    EXPORT uint64_t Simple8bFrameOfReferenceDecode##suffix(uint64_t *input, uint64_t outputLength,            \
+                                                           type *output);                                     \
+    EXPORT uint64_t Simple8bAdaptiveEncode##suffix(const type *input, uint64_t inputLength,                   \
+                                                   uint64_t *output);                                         \
+    EXPORT uint64_t Simple8bAdaptiveDecode##suffix(uint64_t *input, uint64_t outputLength, type *output);     \
+    EXPORT uint64_t Simple8bEncodeBatch##suffix(const type *const *inputs, const uint64_t *lengths,           \
+                                                uint64_t numSeries, uint64_t *output, uint64_t *offsets,      \
+                                                uint32_t numThreads, Simple8bContext *context);               \
+    EXPORT uint64_t Simple8bDecodeBatch##suffix(uint64_t *input, const uint64_t *offsets,                     \
+                                                const uint64_t *lengths, uint64_t numSeries, type *output,    \
+                                                uint32_t numThreads, Simple8bContext *context);
+
+/* delta + zigzag pipelines, for signed element types */
+#define SIMPLE8B_DECLARE_SIGNED_TYPE(suffix, type)                                                                \
+    EXPORT uint64_t Simple8bDeltaZigZagEncode##suffix(const type *input, uint64_t inputLength, uint64_t *output); \
+    EXPORT uint64_t Simple8bDeltaZigZagDecode##suffix(uint64_t *input, uint64_t outputLength, type *output);      \
+    EXPORT uint64_t Simple8bDeltaOfDeltaEncode##suffix(const type *input, uint64_t inputLength,                   \
+                                                       uint64_t *output);                                         \
+    EXPORT uint64_t Simple8bDeltaOfDeltaDecode##suffix(uint64_t *input, uint64_t outputLength, type *output);     \
+    EXPORT void DeltaEncode##suffix(type *input, uint64_t length);                                                \
+    EXPORT void DeltaDecode##suffix(type *input, uint64_t length);                                                \
+    EXPORT void DeltaEncodeInto##suffix(const type *input, uint64_t length, type *output);                        \
+    EXPORT void DeltaDecodeInto##suffix(const type *input, uint64_t length, type *output);                        \
+    EXPORT void ZigZagEncode##suffix(type *input, uint64_t length);                                               \
+    EXPORT void ZigZagDecode##suffix(type *input, uint64_t length);
+
+#ifdef __cplusplus
+extern "C" /* prevent compiler from mangling function names */
+{
+#endif
+    SIMPLE8B_DECLARE_TYPE(U8, uint8_t)
+    SIMPLE8B_DECLARE_TYPE(U16, uint16_t)
+    SIMPLE8B_DECLARE_TYPE(U32, uint32_t)
+    SIMPLE8B_DECLARE_TYPE(U64, uint64_t)
+    SIMPLE8B_DECLARE_TYPE(I8, int8_t)
+    SIMPLE8B_DECLARE_TYPE(I16, int16_t)
+    SIMPLE8B_DECLARE_TYPE(I32, int32_t)
+    SIMPLE8B_DECLARE_TYPE(I64, int64_t)
+
+    SIMPLE8B_DECLARE_SIGNED_TYPE(I8, int8_t)
+    SIMPLE8B_DECLARE_SIGNED_TYPE(I16, int16_t)
+    SIMPLE8B_DECLARE_SIGNED_TYPE(I32, int32_t)
+    SIMPLE8B_DECLARE_SIGNED_TYPE(I64, int64_t)
+
+    EXPORT uint64_t Simple8bMaxCompressedSize(uint64_t inputLength);
+    EXPORT uint64_t Simple8bMaxCompressedSizeForWidth(uint64_t inputLength, uint32_t maxBitWidth);
+    /* reference words before the Simple8b words of a Simple8bFrameOfReferenceEncode stream */
+    EXPORT uint64_t Simple8bFrameOfReferenceHeaderWords(uint64_t inputLength);
+    /* bound on the words written by Simple8bAdaptiveEncode, for any values */
+    EXPORT uint64_t Simple8bAdaptiveMaxCompressedSize(uint64_t inputLength);
+
+    EXPORT uint64_t Simple8bSum(const uint64_t *input, uint64_t uncompressedLength);
+    EXPORT uint64_t Simple8bMin(const uint64_t *input, uint64_t uncompressedLength);
+    EXPORT uint64_t Simple8bMax(const uint64_t *input, uint64_t uncompressedLength);
+    EXPORT int64_t Simple8bDeltaZigZagSum(const uint64_t *input, uint64_t uncompressedLength);
+
+    /* selection filters: bit i of bitmap ((uncompressedLength + 63) / 64 words) set when value i matches */
+    EXPORT uint64_t Simple8bFilterRange(const uint64_t *input, uint64_t uncompressedLength, uint64_t min,
+                                        uint64_t max, uint64_t *bitmap);
+    EXPORT uint64_t Simple8bFilterGreater(const uint64_t *input, uint64_t uncompressedLength, uint64_t threshold,
+                                          uint64_t *bitmap);
+    EXPORT uint64_t Simple8bFilterLess(const uint64_t *input, uint64_t uncompressedLength, uint64_t threshold,
+                                       uint64_t *bitmap);
+    EXPORT uint64_t Simple8bFilterEqual(const uint64_t *input, uint64_t uncompressedLength, uint64_t value,
+                                        uint64_t *bitmap);
+    EXPORT uint64_t Simple8bFilterRangePositions(const uint64_t *input, uint64_t uncompressedLength, uint64_t min,
+                                                 uint64_t max, uint64_t *positions);
+
+    /* the calling thread's counters since its last reset; Simple8bStatsEnabled is 0 when they are compiled out */
+    EXPORT void Simple8bStatsGet(Simple8bStats *stats);
+    EXPORT void Simple8bStatsReset(void);
+    EXPORT int Simple8bStatsEnabled(void);
+
+    EXPORT Simple8bContext *Simple8bContextCreate(void);
+    EXPORT void Simple8bContextDestroy(Simple8bContext *context);
+
+    EXPORT Simple8bSimdLevel Simple8bGetSimdLevel(void);
+    EXPORT void Simple8bSetSimdLevel(Simple8bSimdLevel level);
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SIMPLE8B_H */
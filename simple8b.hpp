@@ -0,0 +1,5002 @@
+/* 
+    Adapted from https://github.com/lemire/FastPFor (Apache License Version 2.0)
+
+    Implements Simple8b integer compression/decompression as described in original paper:
+        Vo Ngoc Anh, Alistair Moffat: Index compression using 64-bit words
+        Softw., Pract. Exper. 40(2): 131-147 (2010)
+
+    Notable changes:
+        - C++ templates used to make methods generic over integer bit-width
+        - support longer arrays via 64 bit length arguments
+
+    Header-only C++ API: include this file and instantiate the templates for your own element
+    types, so the encode and decode loops inline into (and get specialized for) each call site.
+    simple8b.cpp builds the static and shared libraries from it, with the C ABI of simple8b.h
+    as thin wrappers over the templates.
+*/
+
+#ifndef SIMPLE8B_HPP
+#define SIMPLE8B_HPP
+
+#include "simple8b.h"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+// the non-template entry points are also C symbols declared in simple8b.h: inline here, and
+// emitted out of line (and exported) by simple8b.cpp, which defines SIMPLE8B_IMPLEMENTATION
+#if defined(SIMPLE8B_IMPLEMENTATION)
+#define SIMPLE8B_INLINE
+#else
+#define SIMPLE8B_INLINE inline
+#endif
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+// Simple8bFileReader::Open maps files, and Simple8bFilePipeline reads them, where POSIX I/O is available
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define SIMPLE8B_MMAP
+#endif
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <immintrin.h>
+#define SIMPLE8B_X86_SIMD
+#define SIMPLE8B_TARGET_AVX2 __attribute__((target("avx2")))
+#define SIMPLE8B_TARGET_AVX512 __attribute__((target("avx512f")))
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#define SIMPLE8B_NEON_SIMD
+#elif defined(__wasm_simd128__)
+#include <wasm_simd128.h>
+#define SIMPLE8B_WASM_SIMD
+#endif
+
+const uint8_t SIMPLE8B_SELECTOR_BITS = 4; // number of bits used by Simple8b algorithm to indicate packing scheme
+
+// number of integers packed into a word, indexed by selector
+constexpr uint32_t SIMPLE8B_SELECTOR_INTEGERS[16] = {240, 120, 60, 30, 20, 15, 12, 10, 8, 7, 6, 5, 4, 3, 2, 1};
+
+// number of bits used by each packed integer, indexed by selector
+constexpr uint32_t SIMPLE8B_SELECTOR_INT_BITS[16] = {0, 0, 1, 2, 3, 4, 5, 6, 7, 8, 10, 12, 15, 20, 30, 60};
+
+// largest value each selector can hold, indexed by selector
+// selector 15 accepts anything, matching the TryPackFast<1, 60> cascade behaviour
+constexpr uint64_t SIMPLE8B_SELECTOR_MAX_VALUE[16] = {
+    0, 0, (1ULL << 1) - 1, (1ULL << 2) - 1, (1ULL << 3) - 1, (1ULL << 4) - 1, (1ULL << 5) - 1, (1ULL << 6) - 1,
+    (1ULL << 7) - 1, (1ULL << 8) - 1, (1ULL << 10) - 1, (1ULL << 12) - 1, (1ULL << 15) - 1, (1ULL << 20) - 1,
+    (1ULL << 30) - 1, ~0ULL};
+
+// densest selector able to hold an integer of the given bit-width, indexed by bit-width (0-64)
+// widths above 60 map to selector 15, matching the TryPackFast<1, 60> cascade behaviour
+constexpr uint8_t SIMPLE8B_WIDTH_SELECTOR[65] = {
+    0, 2, 3, 4, 5, 6, 7, 8, 9, 10, 10, 11, 11, 12, 12, 12,
+    13, 13, 13, 13, 13, 14, 14, 14, 14, 14, 14, 14, 14, 14, 14, 15,
+    15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15,
+    15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15,
+    15};
+
+// largest value a word can hold; the encoders reject anything wider (see Simple8bEncodeEscaped)
+const uint64_t SIMPLE8B_MAX_VALUE = (1ULL << 60) - 1;
+
+
+// per-selector parameters for the table-driven decode kernel (Simple8bDecodeTable)
+struct Simple8bSelectorInfo
+{
+    uint64_t mask;          // mask of one packed integer
+    uint32_t numBitsPerInt; // distance between consecutive integers in the word
+    uint32_t numIntegers;   // integers held by the word
+    uint32_t numGroups;     // numIntegers rounded up to groups of SIMPLE8B_TABLE_GROUP integers
+};
+
+const uint32_t SIMPLE8B_TABLE_GROUP = 4;
+
+constexpr Simple8bSelectorInfo SIMPLE8B_SELECTOR_INFO[16] = {
+    {0, 0, 240, 60},
+    {0, 0, 120, 30},
+    {(1ULL << 1) - 1, 1, 60, 15},
+    {(1ULL << 2) - 1, 2, 30, 8},
+    {(1ULL << 3) - 1, 3, 20, 5},
+    {(1ULL << 4) - 1, 4, 15, 4},
+    {(1ULL << 5) - 1, 5, 12, 3},
+    {(1ULL << 6) - 1, 6, 10, 3},
+    {(1ULL << 7) - 1, 7, 8, 2},
+    {(1ULL << 8) - 1, 8, 7, 2},
+    {(1ULL << 10) - 1, 10, 6, 2},
+    {(1ULL << 12) - 1, 12, 5, 2},
+    {(1ULL << 15) - 1, 15, 4, 1},
+    {(1ULL << 20) - 1, 20, 3, 1},
+    {(1ULL << 30) - 1, 30, 2, 1},
+    {(1ULL << 60) - 1, 60, 1, 1}};
+
+inline uint32_t GetBitWidth(const uint64_t value)
+{
+#if defined(_MSC_VER)
+    unsigned long index;
+    return _BitScanReverse64(&index, value) ? static_cast<uint32_t>(index) + 1 : 0;
+#else
+    return value == 0 ? 0 : 64 - static_cast<uint32_t>(__builtin_clzll(value));
+#endif
+}
+
+inline uint32_t GetPopCount(const uint64_t value)
+{
+#if defined(_MSC_VER)
+    return static_cast<uint32_t>(__popcnt64(value));
+#else
+    return static_cast<uint32_t>(__builtin_popcountll(value));
+#endif
+}
+
+// index of the lowest set bit, for non-zero values
+inline uint32_t GetTrailingZeros(const uint64_t value)
+{
+#if defined(_MSC_VER)
+    unsigned long index;
+    _BitScanForward64(&index, value);
+    return static_cast<uint32_t>(index);
+#else
+    return static_cast<uint32_t>(__builtin_ctzll(value));
+#endif
+}
+
+// highest selector whose word still has room for the given number of integers (1-240)
+inline uint32_t GetLastSelectorHolding(const uint64_t numIntegers)
+{
+    uint32_t selector = 15;
+    while (SIMPLE8B_SELECTOR_INTEGERS[selector] < numIntegers)
+        selector--;
+    return selector;
+}
+
+template <typename T>
+inline void WriteBits(uint64_t *out, const T value, const uint32_t numBits)
+{
+    *out = (*out << numBits) | value;
+}
+
+template <uint64_t numIntegers, uint32_t numBitsPerInt, typename T>
+inline bool TryPackFast(const T *n)
+{
+    if (numBitsPerInt >= 32)
+        return true;
+    for (uint64_t i = 0; i < numIntegers; i++)
+    {
+        if (n[i] >= (1ULL << numBitsPerInt))
+            return false;
+    }
+    return true;
+}
+
+template <uint64_t numIntegers, uint32_t numBitsPerInt, typename T>
+inline bool TryPackCareful(const T *n, uint64_t maxIntegers)
+{
+    if (numBitsPerInt >= 32)
+        return true;
+    const uint64_t minv = (maxIntegers < numIntegers) ? maxIntegers : numIntegers;
+    for (uint64_t i = 0; i < minv; i++)
+    {
+        if (n[i] >= (1ULL << numBitsPerInt))
+            return false;
+    }
+    return true;
+}
+
+template <uint32_t numIntegers, uint32_t numBitsPerInt, typename T>
+inline void UnpackFast(T *&out, const uint64_t *&in)
+{
+    const uint64_t mask = (1ULL << numBitsPerInt) - 1;
+    if (numBitsPerInt < 32)
+    {
+        for (uint32_t k = 0; k < numIntegers; ++k)
+        {
+            *(out++) = static_cast<T>(in[0] >> (64 - SIMPLE8B_SELECTOR_BITS - numBitsPerInt - k * numBitsPerInt)) & mask;
+        }
+    }
+    else
+    {
+        for (uint32_t k = 0; k < numIntegers; ++k)
+        {
+            *(out++) = static_cast<T>(in[0] >> (64 - SIMPLE8B_SELECTOR_BITS - numBitsPerInt - k * numBitsPerInt)) & mask;
+        }
+    }
+    ++in;
+}
+
+inline uint32_t GetSelectorNum(const uint64_t *const in)
+{
+    return static_cast<uint32_t>((*in) >> (64 - SIMPLE8B_SELECTOR_BITS));
+}
+
+// single pass over the input: returns the first selector (in cascade order) whose word can hold
+// the next min(SIMPLE8B_SELECTOR_INTEGERS[selector], maxIntegers) values
+template <typename T>
+inline uint32_t FindSelector(const T *n, uint64_t maxIntegers)
+{
+    uint32_t selector = 0;
+    uint64_t limit = 0;
+    uint64_t end = (maxIntegers < 240) ? maxIntegers : 240;
+    uint64_t bitsSeen = 0;
+    uint64_t zeros = 0;
+    while (zeros + 8 <= end && (n[zeros] | n[zeros + 1] | n[zeros + 2] | n[zeros + 3] |
+                                n[zeros + 4] | n[zeros + 5] | n[zeros + 6] | n[zeros + 7]) == 0)
+        zeros += 8;
+    if (zeros == end)
+        return selector;
+    for (uint64_t i = zeros + 1;; i++)
+    {
+        bitsSeen |= static_cast<uint64_t>(n[i - 1]);
+        if (bitsSeen > limit)
+        {
+            const uint32_t needed = SIMPLE8B_WIDTH_SELECTOR[GetBitWidth(bitsSeen)];
+            // any selector holding fewer than i integers already fits the values seen before this one
+            const uint32_t last = GetLastSelectorHolding(i);
+            if (last < needed)
+                return last + 1;
+            selector = needed;
+            limit = SIMPLE8B_SELECTOR_MAX_VALUE[selector];
+            if (end > SIMPLE8B_SELECTOR_INTEGERS[selector])
+                end = SIMPLE8B_SELECTOR_INTEGERS[selector];
+        }
+        if (i == end)
+            return selector;
+    }
+}
+
+template <uint32_t numIntegers, uint32_t numBitsPerInt, typename T>
+inline void PackFast(const uint64_t selector, uint64_t *&out, const T *&n)
+{
+    if (numBitsPerInt == 0)
+    {
+        out[0] = selector << (64 - SIMPLE8B_SELECTOR_BITS);
+    }
+    else
+    {
+        out[0] = selector;
+        for (uint32_t i = 0; i < numIntegers; i++)
+            WriteBits(out, n[i], numBitsPerInt);
+        out[0] <<= 64 - SIMPLE8B_SELECTOR_BITS - numBitsPerInt * numIntegers;
+    }
+    n += numIntegers;
+    ++out;
+}
+
+template <uint32_t numBitsPerInt, typename T>
+inline void PackCareful(const uint64_t selector, uint32_t numIntegers, uint64_t *&out, const T *&n)
+{
+    out[0] = selector;
+    for (uint32_t i = 0; i < numIntegers; i++)
+        WriteBits(out, n[i], numBitsPerInt);
+    out[0] <<= 64 - SIMPLE8B_SELECTOR_BITS - numBitsPerInt * numIntegers;
+    n += numIntegers;
+    ++out;
+}
+
+// FindSelector with a whole word's worth of values ahead
+template <typename T>
+inline uint32_t FindSelectorAhead(const T *n)
+{
+    return FindSelector(n, 240);
+}
+
+// encodes words while at least 240 values remain, so every selector sees a whole word's worth;
+// returns false, stopping at the value, if one is above SIMPLE8B_MAX_VALUE
+template <typename T, uint32_t (*findSelector)(const T *) = FindSelectorAhead<T>>
+inline bool EncodeFast(const T *&in, const T *const end, uint64_t *&out)
+{
+    // the switch keeps the number of values coded a compile-time constant per selector, so the
+    // next word's scan does not wait on the selector computation of the previous one
+    while (end - in >= 240)
+    {
+        switch (findSelector(in))
+        {
+        case 0:
+            PackFast<240, 0>(0, out, in);
+            break;
+        case 1:
+            PackFast<120, 0>(1, out, in);
+            break;
+        case 2:
+            PackFast<60, 1>(2, out, in);
+            break;
+        case 3:
+            PackFast<30, 2>(3, out, in);
+            break;
+        case 4:
+            PackFast<20, 3>(4, out, in);
+            break;
+        case 5:
+            PackFast<15, 4>(5, out, in);
+            break;
+        case 6:
+            PackFast<12, 5>(6, out, in);
+            break;
+        case 7:
+            PackFast<10, 6>(7, out, in);
+            break;
+        case 8:
+            PackFast<8, 7>(8, out, in);
+            break;
+        case 9:
+            PackFast<7, 8>(9, out, in);
+            break;
+        case 10:
+            PackFast<6, 10>(10, out, in);
+            break;
+        case 11:
+            PackFast<5, 12>(11, out, in);
+            break;
+        case 12:
+            PackFast<4, 15>(12, out, in);
+            break;
+        case 13:
+            PackFast<3, 20>(13, out, in);
+            break;
+        case 14:
+            PackFast<2, 30>(14, out, in);
+            break;
+        case 15:
+            // every value wider than 30 bits lands here, so this is the only check needed
+            if (static_cast<uint64_t>(*in) > SIMPLE8B_MAX_VALUE)
+                return false;
+            PackFast<1, 60>(15, out, in);
+            break;
+        default:
+            break;
+        }
+    }
+    return true;
+}
+
+// packs the next numIntegers values (at most the selector's count) into one word
+template <typename T>
+inline void PackWord(const uint32_t selector, const uint32_t numIntegers, uint64_t *&out, const T *&in)
+{
+    switch (selector)
+    {
+    case 0:
+    case 1:
+        out[0] = static_cast<uint64_t>(selector) << (64 - SIMPLE8B_SELECTOR_BITS);
+        in += numIntegers;
+        ++out;
+        break;
+    case 2:
+        PackCareful<1>(2, numIntegers, out, in);
+        break;
+    case 3:
+        PackCareful<2>(3, numIntegers, out, in);
+        break;
+    case 4:
+        PackCareful<3>(4, numIntegers, out, in);
+        break;
+    case 5:
+        PackCareful<4>(5, numIntegers, out, in);
+        break;
+    case 6:
+        PackCareful<5>(6, numIntegers, out, in);
+        break;
+    case 7:
+        PackCareful<6>(7, numIntegers, out, in);
+        break;
+    case 8:
+        PackCareful<7>(8, numIntegers, out, in);
+        break;
+    case 9:
+        PackCareful<8>(9, numIntegers, out, in);
+        break;
+    case 10:
+        PackCareful<10>(10, numIntegers, out, in);
+        break;
+    case 11:
+        PackCareful<12>(11, numIntegers, out, in);
+        break;
+    case 12:
+        PackCareful<15>(12, numIntegers, out, in);
+        break;
+    case 13:
+        PackCareful<20>(13, numIntegers, out, in);
+        break;
+    case 14:
+        PackCareful<30>(14, numIntegers, out, in);
+        break;
+    case 15:
+        PackCareful<60>(15, numIntegers, out, in);
+        break;
+    default:
+        break;
+    }
+}
+
+// true when the next value would need a selector 15 word but does not fit one
+template <typename T>
+inline bool IsTooLarge(const uint32_t selector, const T *in)
+{
+    return selector == 15 && static_cast<uint64_t>(*in) > SIMPLE8B_MAX_VALUE;
+}
+
+// encodes the remaining (fewer than 240) values; returns false like EncodeFast
+template <typename T>
+inline bool EncodeCareful(const T *&in, const T *const end, uint64_t *&out)
+{
+    while (end > in)
+    {
+        const uint32_t selector = FindSelector(in, static_cast<uint64_t>(end - in));
+        const uint32_t NumberOfValuesCoded = std::min<uint32_t>(static_cast<uint32_t>(end - in),
+                                                                SIMPLE8B_SELECTOR_INTEGERS[selector]);
+        if (IsTooLarge(selector, in))
+            return false;
+        PackWord(selector, NumberOfValuesCoded, out, in);
+    }
+    return true;
+}
+
+/*
+    Opt-in instrumentation. Built with SIMPLE8B_STATS defined (cmake -DSIMPLE8B_STATS=ON), the
+    codecs add what each call did to a Simple8bStats of the calling thread: words per selector,
+    payload bits left unused and values through the careful loops, for Simple8bEncode,
+    Simple8bDecode and the fused transform pipelines, and the time spent in each phase of the
+    pipelines. Without it the hooks below are empty and compile away.
+*/
+
+#if defined(SIMPLE8B_STATS)
+inline Simple8bStats &ThreadStats()
+{
+    static thread_local Simple8bStats stats = {};
+    return stats;
+}
+
+// TSC ticks on x86, nanoseconds elsewhere
+inline uint64_t GetStatsTicks()
+{
+#if defined(SIMPLE8B_X86_SIMD) || (defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86)))
+    return __rdtsc();
+#else
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                     std::chrono::steady_clock::now().time_since_epoch())
+                                     .count());
+#endif
+}
+
+// adds the time until it goes out of scope to one of the phase counters
+class StatsTimer
+{
+public:
+    explicit StatsTimer(uint64_t Simple8bStats::*counter) : counter(counter), start(GetStatsTicks()) {}
+
+    ~StatsTimer()
+    {
+        ThreadStats().*counter += GetStatsTicks() - start;
+    }
+
+private:
+    uint64_t Simple8bStats::*const counter;
+    const uint64_t start;
+};
+
+// tallies, under stats.*side (encode or decode), a call that packed or unpacked numValues
+// values in numWords words, numCareful of them in the careful loop. The zero-run selectors 0 and
+// 1 leave no bits unused
+inline void CountStats(Simple8bCodecStats Simple8bStats::*side, const uint64_t *words, uint64_t numWords,
+                       uint64_t numValues, uint64_t numCareful)
+{
+    Simple8bCodecStats &codec = ThreadStats().*side;
+    codec.calls++;
+    codec.values += numValues;
+    codec.words += numWords;
+    codec.carefulValues += numCareful;
+    if (numWords == 0)
+        return;
+
+    // four histograms, so runs of one selector do not chain increments of the same counter
+    uint64_t counts[4][16] = {};
+    for (uint64_t i = 0; i + 1 < numWords; i++)
+        counts[i % 4][GetSelectorNum(words + i)]++;
+
+    // every word but the last is full
+    uint64_t position = 0;
+    for (uint32_t selector = 0; selector < 16; selector++)
+    {
+        const uint64_t count = counts[0][selector] + counts[1][selector] + counts[2][selector] + counts[3][selector];
+        codec.selectorWords[selector] += count;
+        position += count * SIMPLE8B_SELECTOR_INTEGERS[selector];
+        if (selector > 1)
+            codec.wastedBits += count * (64 - SIMPLE8B_SELECTOR_BITS - SIMPLE8B_SELECTOR_INTEGERS[selector] *
+                                                                            SIMPLE8B_SELECTOR_INT_BITS[selector]);
+    }
+    const uint32_t last = GetSelectorNum(words + numWords - 1);
+    codec.selectorWords[last]++;
+    if (last > 1)
+        codec.wastedBits += 64 - SIMPLE8B_SELECTOR_BITS - (numValues - position) * SIMPLE8B_SELECTOR_INT_BITS[last];
+}
+#else
+class StatsTimer
+{
+public:
+    explicit StatsTimer(uint64_t Simple8bStats::*) {}
+};
+
+inline void CountStats(Simple8bCodecStats Simple8bStats::*, const uint64_t *, uint64_t, uint64_t, uint64_t) {}
+#endif
+
+// the calling thread's counters since it last reset them (all zero without SIMPLE8B_STATS)
+SIMPLE8B_INLINE void Simple8bStatsGet(Simple8bStats *stats)
+{
+#if defined(SIMPLE8B_STATS)
+    *stats = ThreadStats();
+#else
+    *stats = Simple8bStats();
+#endif
+}
+
+SIMPLE8B_INLINE void Simple8bStatsReset()
+{
+#if defined(SIMPLE8B_STATS)
+    ThreadStats() = Simple8bStats();
+#endif
+}
+
+SIMPLE8B_INLINE int Simple8bStatsEnabled()
+{
+#if defined(SIMPLE8B_STATS)
+    return 1;
+#else
+    return 0;
+#endif
+}
+
+// returns the number of words written, or SIMPLE8B_ERROR_VALUE_TOO_LARGE if a value does not fit
+// in a word (negative ones included), in which case the output holds no usable stream
+template <typename T>
+uint64_t Simple8bEncode(T *input, uint64_t inputLength, uint64_t *out)
+{
+    const uint64_t *const initout = out;
+    const T *in = input;
+    const T *const end = input + inputLength;
+
+    StatsTimer timer(&Simple8bStats::packTicks);
+    if (!EncodeFast(in, end, out))
+        return SIMPLE8B_ERROR_VALUE_TOO_LARGE;
+    const uint64_t numCareful = static_cast<uint64_t>(end - in);
+    if (!EncodeCareful(in, end, out))
+        return SIMPLE8B_ERROR_VALUE_TOO_LARGE;
+
+    CountStats(&Simple8bStats::encode, initout, static_cast<uint64_t>(out - initout), inputLength, numCareful);
+    return out - initout;
+}
+
+// original TryPackFast/TryPackCareful cascade, kept as the reference encoder:
+// Simple8bEncode must produce byte-identical output for values up to SIMPLE8B_MAX_VALUE
+// (wider ones silently corrupt the cascade's stream)
+template <typename T>
+uint64_t Simple8bEncodeCascade(T *input, uint64_t inputLength, uint64_t *out)
+{
+    uint32_t NumberOfValuesCoded = 0;
+    const uint64_t *const initout = out;
+    size_t ValuesRemaining(inputLength);
+
+    while (ValuesRemaining >= 240)
+    {
+        if (TryPackFast<120, 0>(input))
+        {
+            if (TryPackFast<120, 0>(input + 120))
+            {
+                NumberOfValuesCoded = 240;
+                out[0] = 0;
+                input += NumberOfValuesCoded;
+            }
+            else
+            {
+                NumberOfValuesCoded = 120;
+                out[0] = 1ULL << (64 - SIMPLE8B_SELECTOR_BITS);
+                input += NumberOfValuesCoded;
+            }
+        }
+        else if (TryPackFast<60, 1>(input))
+        {
+            out[0] = 2;
+            NumberOfValuesCoded = 60;
+            for (uint32_t i = 0; i < 60; i++)
+            {
+                WriteBits(out, *input++, 1);
+            }
+            out[0] <<= 64 - SIMPLE8B_SELECTOR_BITS - 1 * 60;
+        }
+        else if (TryPackFast<30, 2>(input))
+        {
+            out[0] = 3;
+            NumberOfValuesCoded = 30;
+            for (uint32_t i = 0; i < 30; i++)
+                WriteBits(out, *input++, 2);
+            out[0] <<= 64 - SIMPLE8B_SELECTOR_BITS - 2 * 30;
+        }
+        else if (TryPackFast<20, 3>(input))
+        {
+            out[0] = 4;
+            NumberOfValuesCoded = 20;
+            for (uint32_t i = 0; i < 20; i++)
+                WriteBits(out, *input++, 3);
+            out[0] <<= 64 - SIMPLE8B_SELECTOR_BITS - 3 * 20;
+        }
+        else if (TryPackFast<15, 4>(input))
+        {
+            out[0] = 5;
+            NumberOfValuesCoded = 15;
+            for (uint32_t i = 0; i < 15; i++)
+                WriteBits(out, *input++, 4);
+            out[0] <<= 64 - SIMPLE8B_SELECTOR_BITS - 4 * 15;
+        }
+        else if (TryPackFast<12, 5>(input))
+        {
+            out[0] = 6;
+            NumberOfValuesCoded = 12;
+            for (uint32_t i = 0; i < NumberOfValuesCoded; i++)
+                WriteBits(out, *input++, 5);
+            out[0] <<= 64 - SIMPLE8B_SELECTOR_BITS - 5 * 12;
+        }
+        else if (TryPackFast<10, 6>(input))
+        {
+            out[0] = 7;
+            NumberOfValuesCoded = 10;
+            for (uint32_t i = 0; i < NumberOfValuesCoded; i++)
+                WriteBits(out, *input++, 6);
+            out[0] <<= 64 - SIMPLE8B_SELECTOR_BITS - 6 * 10;
+        }
+        else if (TryPackFast<8, 7>(input))
+        {
+            out[0] = 8;
+            NumberOfValuesCoded = 8;
+            for (uint32_t i = 0; i < NumberOfValuesCoded; i++)
+                WriteBits(out, *input++, 7);
+            out[0] <<= 64 - SIMPLE8B_SELECTOR_BITS - 7 * 8;
+        }
+        else if (TryPackFast<7, 8>(input))
+        {
+            out[0] = 9;
+            NumberOfValuesCoded = 7;
+            for (uint32_t i = 0; i < NumberOfValuesCoded; i++)
+                WriteBits(out, *input++, 8);
+            out[0] <<= 64 - SIMPLE8B_SELECTOR_BITS - 8 * 7;
+        }
+        else if (TryPackFast<6, 10>(input))
+        {
+            out[0] = 10;
+            NumberOfValuesCoded = 6;
+            for (uint32_t i = 0; i < NumberOfValuesCoded; i++)
+                WriteBits(out, *input++, 10);
+            out[0] <<= 64 - SIMPLE8B_SELECTOR_BITS - 10 * 6;
+        }
+        else if (TryPackFast<5, 12>(input))
+        {
+            out[0] = 11;
+            NumberOfValuesCoded = 5;
+            for (uint32_t i = 0; i < NumberOfValuesCoded; i++)
+                WriteBits(out, *input++, 12);
+            out[0] <<= 64 - SIMPLE8B_SELECTOR_BITS - 12 * NumberOfValuesCoded;
+        }
+        else if (TryPackFast<4, 15>(input))
+        {
+            out[0] = 12;
+            NumberOfValuesCoded = 4;
+            for (uint32_t i = 0; i < NumberOfValuesCoded; i++)
+                WriteBits(out, *input++, 15);
+            out[0] <<= 64 - SIMPLE8B_SELECTOR_BITS - 15 * 4;
+        }
+        else if (TryPackFast<3, 20>(input))
+        {
+            out[0] = 13;
+            NumberOfValuesCoded = 3;
+            for (uint32_t i = 0; i < NumberOfValuesCoded; i++)
+                WriteBits(out, *input++, 20);
+            out[0] <<= 64 - SIMPLE8B_SELECTOR_BITS - 20 * 3;
+        }
+        else if (TryPackFast<2, 30>(input))
+        {
+            out[0] = 14;
+            NumberOfValuesCoded = 2;
+            for (uint32_t i = 0; i < NumberOfValuesCoded; i++)
+                WriteBits(out, *input++, 30);
+            out[0] <<= 64 - SIMPLE8B_SELECTOR_BITS - 30 * 2;
+        }
+        else if (TryPackFast<1, 60>(input))
+        {
+            out[0] = 15;
+            NumberOfValuesCoded = 1;
+            for (uint32_t i = 0; i < NumberOfValuesCoded; i++)
+                WriteBits(out, *input++, 60);
+            out[0] <<= 64 - SIMPLE8B_SELECTOR_BITS - 60 * 1;
+        }
+        else
+        {
+            // throw std::logic_error("shouldn't happen");
+        }
+        ++out;
+
+        ValuesRemaining -= NumberOfValuesCoded;
+    }
+    while (ValuesRemaining > 0)
+    {
+        if (TryPackCareful<240, 0>(input, ValuesRemaining))
+        {
+            NumberOfValuesCoded = (ValuesRemaining < 240)
+                                      ? static_cast<uint32_t>(ValuesRemaining)
+                                      : 240;
+            out[0] = 0;
+            input += NumberOfValuesCoded;
+        }
+        else if (TryPackCareful<120, 0>(input, ValuesRemaining))
+        {
+            NumberOfValuesCoded = (ValuesRemaining < 120)
+                                      ? static_cast<uint32_t>(ValuesRemaining)
+                                      : 120;
+            out[0] = 1ULL << (64 - SIMPLE8B_SELECTOR_BITS);
+            input += NumberOfValuesCoded;
+        }
+        else if (TryPackCareful<60, 1>(input, ValuesRemaining))
+        {
+            out[0] = 2;
+            NumberOfValuesCoded =
+                (ValuesRemaining < 60) ? static_cast<uint32_t>(ValuesRemaining) : 60;
+            for (uint32_t i = 0; i < NumberOfValuesCoded; i++)
+            {
+                WriteBits(out, *input++, 1);
+            }
+            out[0] <<= 64 - SIMPLE8B_SELECTOR_BITS - 1 * NumberOfValuesCoded;
+        }
+        else if (TryPackCareful<30, 2>(input, ValuesRemaining))
+        {
+            out[0] = 3;
+            NumberOfValuesCoded =
+                (ValuesRemaining < 30) ? static_cast<uint32_t>(ValuesRemaining) : 30;
+            for (uint32_t i = 0; i < NumberOfValuesCoded; i++)
+                WriteBits(out, *input++, 2);
+            out[0] <<= 64 - SIMPLE8B_SELECTOR_BITS - 2 * NumberOfValuesCoded;
+        }
+        else if (TryPackCareful<20, 3>(input, ValuesRemaining))
+        {
+            out[0] = 4;
+            NumberOfValuesCoded =
+                (ValuesRemaining < 20) ? static_cast<uint32_t>(ValuesRemaining) : 20;
+            for (uint32_t i = 0; i < NumberOfValuesCoded; i++)
+                WriteBits(out, *input++, 3);
+            out[0] <<= 64 - SIMPLE8B_SELECTOR_BITS - 3 * NumberOfValuesCoded;
+        }
+        else if (TryPackCareful<15, 4>(input, ValuesRemaining))
+        {
+            out[0] = 5;
+            NumberOfValuesCoded =
+                (ValuesRemaining < 15) ? static_cast<uint32_t>(ValuesRemaining) : 15;
+            for (uint32_t i = 0; i < NumberOfValuesCoded; i++)
+                WriteBits(out, *input++, 4);
+            out[0] <<= 64 - SIMPLE8B_SELECTOR_BITS - 4 * NumberOfValuesCoded;
+        }
+        else if (TryPackCareful<12, 5>(input, ValuesRemaining))
+        {
+            out[0] = 6;
+            NumberOfValuesCoded =
+                (ValuesRemaining < 12) ? static_cast<uint32_t>(ValuesRemaining) : 12;
+            for (uint32_t i = 0; i < NumberOfValuesCoded; i++)
+                WriteBits(out, *input++, 5);
+            out[0] <<= 64 - SIMPLE8B_SELECTOR_BITS - 5 * NumberOfValuesCoded;
+        }
+        else if (TryPackCareful<10, 6>(input, ValuesRemaining))
+        {
+            out[0] = 7;
+            NumberOfValuesCoded =
+                (ValuesRemaining < 10) ? static_cast<uint32_t>(ValuesRemaining) : 10;
+            for (uint32_t i = 0; i < NumberOfValuesCoded; i++)
+                WriteBits(out, *input++, 6);
+            out[0] <<= 64 - SIMPLE8B_SELECTOR_BITS - 6 * NumberOfValuesCoded;
+        }
+        else if (TryPackCareful<8, 7>(input, ValuesRemaining))
+        {
+            out[0] = 8;
+            NumberOfValuesCoded =
+                (ValuesRemaining < 8) ? static_cast<uint32_t>(ValuesRemaining) : 8;
+            for (uint32_t i = 0; i < NumberOfValuesCoded; i++)
+                WriteBits(out, *input++, 7);
+            out[0] <<= 64 - SIMPLE8B_SELECTOR_BITS - 7 * NumberOfValuesCoded;
+        }
+        else if (TryPackCareful<7, 8>(input, ValuesRemaining))
+        {
+            out[0] = 9;
+            NumberOfValuesCoded =
+                (ValuesRemaining < 7) ? static_cast<uint32_t>(ValuesRemaining) : 7;
+            for (uint32_t i = 0; i < NumberOfValuesCoded; i++)
+                WriteBits(out, *input++, 8);
+            out[0] <<= 64 - SIMPLE8B_SELECTOR_BITS - 8 * NumberOfValuesCoded;
+        }
+        else if (TryPackCareful<6, 10>(input, ValuesRemaining))
+        {
+            out[0] = 10;
+            NumberOfValuesCoded =
+                (ValuesRemaining < 6) ? static_cast<uint32_t>(ValuesRemaining) : 6;
+            for (uint32_t i = 0; i < NumberOfValuesCoded; i++)
+                WriteBits(out, *input++, 10);
+            out[0] <<= 64 - SIMPLE8B_SELECTOR_BITS - 10 * NumberOfValuesCoded;
+        }
+        else if (TryPackCareful<5, 12>(input, ValuesRemaining))
+        {
+            out[0] = 11;
+            NumberOfValuesCoded =
+                (ValuesRemaining < 5) ? static_cast<uint32_t>(ValuesRemaining) : 5;
+            for (uint32_t i = 0; i < NumberOfValuesCoded; i++)
+                WriteBits(out, *input++, 12);
+            out[0] <<= 64 - SIMPLE8B_SELECTOR_BITS - 12 * NumberOfValuesCoded;
+        }
+        else if (TryPackCareful<4, 15>(input, ValuesRemaining))
+        {
+            out[0] = 12;
+            NumberOfValuesCoded =
+                (ValuesRemaining < 4) ? static_cast<uint32_t>(ValuesRemaining) : 4;
+            for (uint32_t i = 0; i < NumberOfValuesCoded; i++)
+                WriteBits(out, *input++, 15);
+            out[0] <<= 64 - SIMPLE8B_SELECTOR_BITS - 15 * NumberOfValuesCoded;
+        }
+        else if (TryPackCareful<3, 20>(input, ValuesRemaining))
+        {
+            out[0] = 13;
+            NumberOfValuesCoded =
+                (ValuesRemaining < 3) ? static_cast<uint32_t>(ValuesRemaining) : 3;
+            for (uint32_t i = 0; i < NumberOfValuesCoded; i++)
+                WriteBits(out, *input++, 20);
+            out[0] <<= 64 - SIMPLE8B_SELECTOR_BITS - 20 * NumberOfValuesCoded;
+        }
+        else if (TryPackCareful<2, 30>(input, ValuesRemaining))
+        {
+            out[0] = 14;
+            NumberOfValuesCoded =
+                (ValuesRemaining < 2) ? static_cast<uint32_t>(ValuesRemaining) : 2;
+            for (uint32_t i = 0; i < NumberOfValuesCoded; i++)
+                WriteBits(out, *input++, 30);
+            out[0] <<= 64 - SIMPLE8B_SELECTOR_BITS - 30 * NumberOfValuesCoded;
+        }
+        else if (TryPackCareful<1, 60>(input, ValuesRemaining))
+        {
+            out[0] = 15;
+            NumberOfValuesCoded = (ValuesRemaining < 1) ? ValuesRemaining : 1;
+            for (uint32_t i = 0; i < NumberOfValuesCoded; i++)
+                WriteBits(out, *input++, 60);
+            out[0] <<= 64 - SIMPLE8B_SELECTOR_BITS - 60 * NumberOfValuesCoded;
+        }
+        else
+        {
+            // throw std::logic_error("shouldn't happen");
+        }
+
+        ++out;
+
+        ValuesRemaining -= NumberOfValuesCoded;
+    }
+
+    return (out)-initout;
+}
+
+/*
+    Vectorized unpack kernels for 64-bit outputs, used by the fast decode loop.
+
+    Each kernel broadcasts the word to every lane, shifts each lane right by the offset of its
+    integer and masks it. Kernels always store whole vectors, so up to (lanes - 1) values past
+    the end of the word get written; the fast decode loop has at least 240 values of room left
+    and the following word overwrites them.
+
+    UnpackFast remains the scalar fallback and the reference implementation. It also handles
+    selectors 14 and 15, which hold too few integers for a vector to pay off.
+
+    WebAssembly builds with -msimd128 get 2-lane kernels. Wasm has no runtime feature detection,
+    so SIMD128 is a build-time choice and SIMPLE8B_SIMD_WASM128 is the only level above scalar.
+*/
+
+inline Simple8bSimdLevel DetectSimdLevel()
+{
+#if defined(SIMPLE8B_X86_SIMD)
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx512f"))
+        return SIMPLE8B_SIMD_AVX512;
+    if (__builtin_cpu_supports("avx2"))
+        return SIMPLE8B_SIMD_AVX2;
+#elif defined(SIMPLE8B_NEON_SIMD)
+    return SIMPLE8B_SIMD_NEON;
+#elif defined(SIMPLE8B_WASM_SIMD)
+    return SIMPLE8B_SIMD_WASM128;
+#endif
+    return SIMPLE8B_SIMD_SCALAR;
+}
+
+inline Simple8bSimdLevel &ActiveSimdLevel()
+{
+    static Simple8bSimdLevel level = DetectSimdLevel();
+    return level;
+}
+
+// kernel set used by Simple8bDecode: the best one the running CPU supports unless lowered
+SIMPLE8B_INLINE Simple8bSimdLevel Simple8bGetSimdLevel()
+{
+    return ActiveSimdLevel();
+}
+
+// restrict decoding to a lower kernel set (eg SIMPLE8B_SIMD_SCALAR to compare against the reference
+// kernels); levels the CPU does not support are clamped to the detected one
+SIMPLE8B_INLINE void Simple8bSetSimdLevel(Simple8bSimdLevel level)
+{
+    const Simple8bSimdLevel detected = DetectSimdLevel();
+    ActiveSimdLevel() = (level < detected) ? level : detected;
+}
+
+#if defined(SIMPLE8B_X86_SIMD)
+template <uint32_t numIntegers, uint32_t numBitsPerInt>
+SIMPLE8B_TARGET_AVX2 inline void UnpackFastAvx2(uint64_t *&out, const uint64_t *&in)
+{
+    const int64_t first = 64 - SIMPLE8B_SELECTOR_BITS - numBitsPerInt;
+    const __m256i word = _mm256_set1_epi64x(static_cast<long long>(in[0]));
+    const __m256i mask = _mm256_set1_epi64x(static_cast<long long>((1ULL << numBitsPerInt) - 1));
+    const __m256i step = _mm256_set1_epi64x(4 * numBitsPerInt);
+    // lanes past the last integer get a negative shift, which srlv treats as >= 64 and zeroes
+    __m256i shifts = _mm256_set_epi64x(first - 3 * numBitsPerInt, first - 2 * numBitsPerInt,
+                                       first - numBitsPerInt, first);
+    for (uint32_t k = 0; k < numIntegers; k += 4)
+    {
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(out + k),
+                            _mm256_and_si256(_mm256_srlv_epi64(word, shifts), mask));
+        shifts = _mm256_sub_epi64(shifts, step);
+    }
+    out += numIntegers;
+    ++in;
+}
+
+template <uint32_t numIntegers, uint32_t numBitsPerInt>
+SIMPLE8B_TARGET_AVX512 inline void UnpackFastAvx512(uint64_t *&out, const uint64_t *&in)
+{
+    const int64_t first = 64 - SIMPLE8B_SELECTOR_BITS - numBitsPerInt;
+    const __m512i word = _mm512_set1_epi64(static_cast<long long>(in[0]));
+    const __m512i mask = _mm512_set1_epi64(static_cast<long long>((1ULL << numBitsPerInt) - 1));
+    const __m512i step = _mm512_set1_epi64(8 * numBitsPerInt);
+    __m512i shifts = _mm512_set_epi64(first - 7 * numBitsPerInt, first - 6 * numBitsPerInt,
+                                      first - 5 * numBitsPerInt, first - 4 * numBitsPerInt,
+                                      first - 3 * numBitsPerInt, first - 2 * numBitsPerInt,
+                                      first - numBitsPerInt, first);
+    for (uint32_t k = 0; k < numIntegers; k += 8)
+    {
+        _mm512_storeu_si512(out + k, _mm512_and_si512(_mm512_srlv_epi64(word, shifts), mask));
+        shifts = _mm512_sub_epi64(shifts, step);
+    }
+    out += numIntegers;
+    ++in;
+}
+
+SIMPLE8B_TARGET_AVX2 inline void DecodeFastAvx2(const uint64_t *&input, uint64_t *&output, const uint64_t *const end)
+{
+    // work on local copies so the pointers stay in registers across the stores
+    const uint64_t *in = input;
+    uint64_t *out = output;
+    while (end > out + 240)
+    {
+        switch (GetSelectorNum(in))
+        {
+        case 0:
+            UnpackFastAvx2<240, 0>(out, in);
+            break;
+        case 1:
+            UnpackFastAvx2<120, 0>(out, in);
+            break;
+        case 2:
+            UnpackFastAvx2<60, 1>(out, in);
+            break;
+        case 3:
+            UnpackFastAvx2<30, 2>(out, in);
+            break;
+        case 4:
+            UnpackFastAvx2<20, 3>(out, in);
+            break;
+        case 5:
+            UnpackFastAvx2<15, 4>(out, in);
+            break;
+        case 6:
+            UnpackFastAvx2<12, 5>(out, in);
+            break;
+        case 7:
+            UnpackFastAvx2<10, 6>(out, in);
+            break;
+        case 8:
+            UnpackFastAvx2<8, 7>(out, in);
+            break;
+        case 9:
+            UnpackFastAvx2<7, 8>(out, in);
+            break;
+        case 10:
+            UnpackFastAvx2<6, 10>(out, in);
+            break;
+        case 11:
+            UnpackFastAvx2<5, 12>(out, in);
+            break;
+        case 12:
+            UnpackFastAvx2<4, 15>(out, in);
+            break;
+        case 13:
+            UnpackFastAvx2<3, 20>(out, in);
+            break;
+        case 14:
+            UnpackFast<2, 30>(out, in);
+            break;
+        case 15:
+            UnpackFast<1, 60>(out, in);
+            break;
+        default:
+            break;
+        }
+    }
+    input = in;
+    output = out;
+}
+
+SIMPLE8B_TARGET_AVX512 inline void DecodeFastAvx512(const uint64_t *&input, uint64_t *&output, const uint64_t *const end)
+{
+    // work on local copies so the pointers stay in registers across the stores
+    const uint64_t *in = input;
+    uint64_t *out = output;
+    while (end > out + 240)
+    {
+        switch (GetSelectorNum(in))
+        {
+        case 0:
+            UnpackFastAvx512<240, 0>(out, in);
+            break;
+        case 1:
+            UnpackFastAvx512<120, 0>(out, in);
+            break;
+        case 2:
+            UnpackFastAvx512<60, 1>(out, in);
+            break;
+        case 3:
+            UnpackFastAvx512<30, 2>(out, in);
+            break;
+        case 4:
+            UnpackFastAvx512<20, 3>(out, in);
+            break;
+        case 5:
+            UnpackFastAvx512<15, 4>(out, in);
+            break;
+        case 6:
+            UnpackFastAvx512<12, 5>(out, in);
+            break;
+        case 7:
+            UnpackFastAvx512<10, 6>(out, in);
+            break;
+        case 8:
+            UnpackFastAvx512<8, 7>(out, in);
+            break;
+        case 9:
+            UnpackFastAvx512<7, 8>(out, in);
+            break;
+        case 10:
+            UnpackFastAvx512<6, 10>(out, in);
+            break;
+        case 11:
+            UnpackFastAvx512<5, 12>(out, in);
+            break;
+        case 12:
+            UnpackFastAvx512<4, 15>(out, in);
+            break;
+        case 13:
+            UnpackFastAvx512<3, 20>(out, in);
+            break;
+        case 14:
+            UnpackFast<2, 30>(out, in);
+            break;
+        case 15:
+            UnpackFast<1, 60>(out, in);
+            break;
+        default:
+            break;
+        }
+    }
+    input = in;
+    output = out;
+}
+#endif
+
+#if defined(SIMPLE8B_NEON_SIMD)
+template <uint32_t numIntegers, uint32_t numBitsPerInt>
+inline void UnpackFastNeon(uint64_t *&out, const uint64_t *&in)
+{
+    // vshlq_u64 shifts right for negative shift counts
+    const int64_t first = 64 - SIMPLE8B_SELECTOR_BITS - numBitsPerInt;
+    const uint64x2_t word = vdupq_n_u64(in[0]);
+    const uint64x2_t mask = vdupq_n_u64((1ULL << numBitsPerInt) - 1);
+    const int64x2_t step = vdupq_n_s64(2 * numBitsPerInt);
+    int64x2_t shifts = vcombine_s64(vcreate_s64(static_cast<uint64_t>(-first)),
+                                    vcreate_s64(static_cast<uint64_t>(numBitsPerInt - first)));
+    for (uint32_t k = 0; k < numIntegers; k += 2)
+    {
+        vst1q_u64(out + k, vandq_u64(vshlq_u64(word, shifts), mask));
+        shifts = vaddq_s64(shifts, step);
+    }
+    out += numIntegers;
+    ++in;
+}
+
+inline void DecodeFastNeon(const uint64_t *&input, uint64_t *&output, const uint64_t *const end)
+{
+    // work on local copies so the pointers stay in registers across the stores
+    const uint64_t *in = input;
+    uint64_t *out = output;
+    while (end > out + 240)
+    {
+        switch (GetSelectorNum(in))
+        {
+        case 0:
+            UnpackFastNeon<240, 0>(out, in);
+            break;
+        case 1:
+            UnpackFastNeon<120, 0>(out, in);
+            break;
+        case 2:
+            UnpackFastNeon<60, 1>(out, in);
+            break;
+        case 3:
+            UnpackFastNeon<30, 2>(out, in);
+            break;
+        case 4:
+            UnpackFastNeon<20, 3>(out, in);
+            break;
+        case 5:
+            UnpackFastNeon<15, 4>(out, in);
+            break;
+        case 6:
+            UnpackFastNeon<12, 5>(out, in);
+            break;
+        case 7:
+            UnpackFastNeon<10, 6>(out, in);
+            break;
+        case 8:
+            UnpackFastNeon<8, 7>(out, in);
+            break;
+        case 9:
+            UnpackFastNeon<7, 8>(out, in);
+            break;
+        case 10:
+            UnpackFastNeon<6, 10>(out, in);
+            break;
+        case 11:
+            UnpackFastNeon<5, 12>(out, in);
+            break;
+        case 12:
+            UnpackFastNeon<4, 15>(out, in);
+            break;
+        case 13:
+            UnpackFastNeon<3, 20>(out, in);
+            break;
+        case 14:
+            UnpackFast<2, 30>(out, in);
+            break;
+        case 15:
+            UnpackFast<1, 60>(out, in);
+            break;
+        default:
+            break;
+        }
+    }
+    input = in;
+    output = out;
+}
+#endif
+
+#if defined(SIMPLE8B_WASM_SIMD)
+template <uint32_t numIntegers, uint32_t numBitsPerInt>
+inline void UnpackFastWasm(uint64_t *&out, const uint64_t *&in)
+{
+    // SIMD128 shifts every lane by the same count, so instead of per-lane right shifts each lane
+    // keeps its integer at the top of the word: one shift right extracts the pair, and one
+    // shift left moves both lanes on by two integers
+    if (numBitsPerInt == 0)
+    {
+        for (uint32_t k = 0; k < numIntegers; k += 2)
+            wasm_v128_store(out + k, wasm_u64x2_splat(0));
+    }
+    else
+    {
+        v128_t pair = wasm_u64x2_make(in[0] << SIMPLE8B_SELECTOR_BITS, in[0] << (SIMPLE8B_SELECTOR_BITS + numBitsPerInt));
+        for (uint32_t k = 0; k < numIntegers; k += 2)
+        {
+            wasm_v128_store(out + k, wasm_u64x2_shr(pair, 64 - numBitsPerInt));
+            pair = wasm_i64x2_shl(pair, 2 * numBitsPerInt);
+        }
+    }
+    out += numIntegers;
+    ++in;
+}
+
+inline void DecodeFastWasm(const uint64_t *&input, uint64_t *&output, const uint64_t *const end)
+{
+    // work on local copies so the pointers stay in registers across the stores
+    const uint64_t *in = input;
+    uint64_t *out = output;
+    while (end > out + 240)
+    {
+        switch (GetSelectorNum(in))
+        {
+        case 0:
+            UnpackFastWasm<240, 0>(out, in);
+            break;
+        case 1:
+            UnpackFastWasm<120, 0>(out, in);
+            break;
+        case 2:
+            UnpackFastWasm<60, 1>(out, in);
+            break;
+        case 3:
+            UnpackFastWasm<30, 2>(out, in);
+            break;
+        case 4:
+            UnpackFastWasm<20, 3>(out, in);
+            break;
+        case 5:
+            UnpackFastWasm<15, 4>(out, in);
+            break;
+        case 6:
+            UnpackFastWasm<12, 5>(out, in);
+            break;
+        case 7:
+            UnpackFastWasm<10, 6>(out, in);
+            break;
+        case 8:
+            UnpackFastWasm<8, 7>(out, in);
+            break;
+        case 9:
+            UnpackFastWasm<7, 8>(out, in);
+            break;
+        case 10:
+            UnpackFastWasm<6, 10>(out, in);
+            break;
+        case 11:
+            UnpackFastWasm<5, 12>(out, in);
+            break;
+        case 12:
+            UnpackFastWasm<4, 15>(out, in);
+            break;
+        case 13:
+            UnpackFastWasm<3, 20>(out, in);
+            break;
+        case 14:
+            UnpackFast<2, 30>(out, in);
+            break;
+        case 15:
+            UnpackFast<1, 60>(out, in);
+            break;
+        default:
+            break;
+        }
+    }
+    input = in;
+    output = out;
+}
+#endif
+
+template <typename T>
+inline void UnpackWord(T *&out, const uint64_t *&in)
+{
+    switch (GetSelectorNum(in))
+    {
+    case 0:
+        UnpackFast<240, 0>(out, in);
+        break;
+    case 1:
+        UnpackFast<120, 0>(out, in);
+        break;
+    case 2:
+        UnpackFast<60, 1>(out, in);
+        break;
+    case 3:
+        UnpackFast<30, 2>(out, in);
+        break;
+    case 4:
+        UnpackFast<20, 3>(out, in);
+        break;
+    case 5:
+        UnpackFast<15, 4>(out, in);
+        break;
+    case 6:
+        UnpackFast<12, 5>(out, in);
+        break;
+    case 7:
+        UnpackFast<10, 6>(out, in);
+        break;
+    case 8:
+        UnpackFast<8, 7>(out, in);
+        break;
+    case 9:
+        UnpackFast<7, 8>(out, in);
+        break;
+    case 10:
+        UnpackFast<6, 10>(out, in);
+        break;
+    case 11:
+        UnpackFast<5, 12>(out, in);
+        break;
+    case 12:
+        UnpackFast<4, 15>(out, in);
+        break;
+    case 13:
+        UnpackFast<3, 20>(out, in);
+        break;
+    case 14:
+        UnpackFast<2, 30>(out, in);
+        break;
+    case 15:
+        UnpackFast<1, 60>(out, in);
+        break;
+    default:
+        break;
+    }
+}
+
+// runs the fast decode loop with the active kernel set; leaves everything to the scalar loop
+// when no vector kernels are available
+inline void DecodeFastSimd(const uint64_t *&in, uint64_t *&out, const uint64_t *const end)
+{
+    switch (ActiveSimdLevel())
+    {
+#if defined(SIMPLE8B_X86_SIMD)
+    case SIMPLE8B_SIMD_AVX512:
+        DecodeFastAvx512(in, out, end);
+        break;
+    case SIMPLE8B_SIMD_AVX2:
+        DecodeFastAvx2(in, out, end);
+        break;
+#elif defined(SIMPLE8B_NEON_SIMD)
+    case SIMPLE8B_SIMD_NEON:
+        DecodeFastNeon(in, out, end);
+        break;
+#elif defined(SIMPLE8B_WASM_SIMD)
+    case SIMPLE8B_SIMD_WASM128:
+        DecodeFastWasm(in, out, end);
+        break;
+#endif
+    default:
+        break;
+    }
+}
+
+// decodes words while more than 240 values of room are left, with the vector kernels when the
+// output is 64-bit
+template <typename T>
+inline void DecodeFast(const uint64_t *&in, T *&out, const T *const end)
+{
+    if (sizeof(T) == sizeof(uint64_t))
+    {
+        uint64_t *out64 = reinterpret_cast<uint64_t *>(out);
+        DecodeFastSimd(in, out64, reinterpret_cast<const uint64_t *>(end));
+        out = reinterpret_cast<T *>(out64);
+    }
+
+    while (end > out + 240)
+        UnpackWord(out, in);
+}
+
+// the last words are unpacked whole into a scratch buffer, so the kernels keep their
+// compile-time bounds, and only the values still needed are copied out
+template <typename T>
+inline void DecodeCareful(const uint64_t *&in, T *&out, const T *const end)
+{
+    T scratch[240];
+    while (end > out)
+    {
+        T *tmp = scratch;
+        UnpackWord(tmp, in);
+        const uint64_t numIntegers = std::min<uint64_t>(static_cast<uint64_t>(tmp - scratch),
+                                                        static_cast<uint64_t>(end - out));
+        std::copy(scratch, scratch + numIntegers, out);
+        out += numIntegers;
+    }
+}
+
+template <typename T>
+const uint64_t Simple8bDecode(uint64_t *input, uint64_t uncompressedLength, T *out)
+{
+    const uint64_t *in = input;
+    const T *const end = out + uncompressedLength;
+    const T *const initout = out;
+
+    StatsTimer timer(&Simple8bStats::unpackTicks);
+    DecodeFast(in, out, end);
+    const uint64_t numCareful = static_cast<uint64_t>(end - out);
+    DecodeCareful(in, out, end);
+
+    CountStats(&Simple8bStats::decode, input, static_cast<uint64_t>(in - input), uncompressedLength, numCareful);
+    // ASSERT(out < end + 240, out - end);
+    return out - initout;
+}
+
+// unpacks one word without branching on its selector: the selector only indexes
+// SIMPLE8B_SELECTOR_INFO, and selectors 12-15 all run the same single group of straight-line code.
+// Writes whole groups, ie up to SIMPLE8B_TABLE_GROUP - 1 junk values past the word's integers
+template <typename T>
+inline void UnpackTable(T *&out, const uint64_t *&in)
+{
+    const uint64_t word = in[0];
+    const Simple8bSelectorInfo &info = SIMPLE8B_SELECTOR_INFO[GetSelectorNum(in)];
+    // the shift wraps below zero for the junk values, masking it keeps the shift defined
+    uint32_t shift = 64 - SIMPLE8B_SELECTOR_BITS - info.numBitsPerInt;
+    T *group = out;
+    for (uint32_t g = 0; g < info.numGroups; g++)
+    {
+        group[0] = static_cast<T>(word >> (shift & 63)) & info.mask;
+        group[1] = static_cast<T>(word >> ((shift - info.numBitsPerInt) & 63)) & info.mask;
+        group[2] = static_cast<T>(word >> ((shift - 2 * info.numBitsPerInt) & 63)) & info.mask;
+        group[3] = static_cast<T>(word >> ((shift - 3 * info.numBitsPerInt) & 63)) & info.mask;
+        shift -= SIMPLE8B_TABLE_GROUP * info.numBitsPerInt;
+        group += SIMPLE8B_TABLE_GROUP;
+    }
+    out += info.numIntegers;
+    ++in;
+}
+
+// same output as Simple8bDecode, using the table-driven UnpackTable kernel instead of a switch
+// over the selector, for series whose selectors change too often for the switch to predict well
+template <typename T>
+const uint64_t Simple8bDecodeTable(uint64_t *input, uint64_t uncompressedLength, T *out)
+{
+    const uint64_t *in = input;
+    const T *const end = out + uncompressedLength;
+    const T *const initout = out;
+
+    while (end > out + 240)
+        UnpackTable(out, in);
+
+    T scratch[240 + SIMPLE8B_TABLE_GROUP];
+    while (end > out)
+    {
+        T *tmp = scratch;
+        UnpackTable(tmp, in);
+        const uint64_t numIntegers = std::min<uint64_t>(static_cast<uint64_t>(tmp - scratch),
+                                                        static_cast<uint64_t>(end - out));
+        std::copy(scratch, scratch + numIntegers, out);
+        out += numIntegers;
+    }
+
+    return out - initout;
+}
+
+/*
+    Pre-scan encoder: same output as Simple8bEncode, with the selector of each word found by
+    OR-reducing windows of values rather than by scanning them one at a time.
+
+    The width of the OR of the first 8 values (from its leading zero count) names the densest
+    selector for them. Above 7 bits that selector holds at most 8 values and so already fits:
+    it is an upper bound, eg 15 straight away for anything over 30 bits, and only denser
+    selectors with shorter prefixes remain to be tried. At 7 bits or less it holds 8 or more
+    values: no denser selector can fit the first 8, so it is a lower bound, and sparser
+    selectors are tried until one fits its whole word's worth. All-zero windows go on to the
+    60, 120 and 240-value zero runs. Windows are reduced with vector ORs for 64-bit values.
+*/
+
+template <typename T>
+inline uint64_t OrReduce(const T *n, uint64_t numIntegers)
+{
+    uint64_t bits = 0;
+    for (uint64_t i = 0; i < numIntegers; i++)
+        bits |= static_cast<uint64_t>(n[i]);
+    return bits;
+}
+
+#if defined(SIMPLE8B_X86_SIMD)
+SIMPLE8B_TARGET_AVX2 inline uint64_t OrReduceAvx2(const uint64_t *n, uint64_t numIntegers)
+{
+    __m256i bits = _mm256_setzero_si256();
+    const uint64_t numVectors = numIntegers / 4;
+    uint64_t i = 0;
+    for (; i < 4 * numVectors; i += 4)
+        bits = _mm256_or_si256(bits, _mm256_loadu_si256(reinterpret_cast<const __m256i *>(n + i)));
+    const __m128i half = _mm_or_si128(_mm256_castsi256_si128(bits), _mm256_extracti128_si256(bits, 1));
+    uint64_t scalar = static_cast<uint64_t>(_mm_cvtsi128_si64(_mm_or_si128(half, _mm_unpackhi_epi64(half, half))));
+    for (; i < numIntegers; i++)
+        scalar |= n[i];
+    return scalar;
+}
+#endif
+
+#if defined(SIMPLE8B_NEON_SIMD)
+inline uint64_t OrReduceNeon(const uint64_t *n, uint64_t numIntegers)
+{
+    uint64x2_t bits = vdupq_n_u64(0);
+    uint64_t i = 0;
+    for (; i + 2 <= numIntegers; i += 2)
+        bits = vorrq_u64(bits, vld1q_u64(n + i));
+    uint64_t scalar = vgetq_lane_u64(bits, 0) | vgetq_lane_u64(bits, 1);
+    for (; i < numIntegers; i++)
+        scalar |= n[i];
+    return scalar;
+}
+#endif
+
+#if defined(SIMPLE8B_WASM_SIMD)
+inline uint64_t OrReduceWasm(const uint64_t *n, uint64_t numIntegers)
+{
+    v128_t bits = wasm_u64x2_splat(0);
+    uint64_t i = 0;
+    for (; i + 2 <= numIntegers; i += 2)
+        bits = wasm_v128_or(bits, wasm_v128_load(n + i));
+    uint64_t scalar = wasm_u64x2_extract_lane(bits, 0) | wasm_u64x2_extract_lane(bits, 1);
+    for (; i < numIntegers; i++)
+        scalar |= n[i];
+    return scalar;
+}
+#endif
+
+// same selector as FindSelector(n, 240), at least 240 values being left
+template <typename T, uint64_t (*orReduce)(const T *, uint64_t)>
+inline uint32_t FindSelectorPrescan(const T *n)
+{
+    const uint64_t head = orReduce(n, 8);
+    uint32_t selector = SIMPLE8B_WIDTH_SELECTOR[GetBitWidth(head)];
+    if (selector > 8)
+    {
+        // an upper bound: lower it while the next denser selector still fits (selector 8 cannot)
+        while (selector > 9 && orReduce(n, SIMPLE8B_SELECTOR_INTEGERS[selector - 1]) <=
+                                   SIMPLE8B_SELECTOR_MAX_VALUE[selector - 1])
+            selector--;
+        return selector;
+    }
+
+    if (selector == 0)
+    {
+        const uint64_t window = orReduce(n + 8, 52);
+        if (window == 0)
+            return (orReduce(n + 60, 60) != 0) ? 2 : (orReduce(n + 120, 120) != 0) ? 1 : 0;
+        selector = 2;
+    }
+    // a lower bound: raise it until a word's worth of values fits (selector 8 always does)
+    while (selector < 8 && orReduce(n, SIMPLE8B_SELECTOR_INTEGERS[selector]) > SIMPLE8B_SELECTOR_MAX_VALUE[selector])
+        selector++;
+    return selector;
+}
+
+#if defined(SIMPLE8B_X86_SIMD)
+// flattened, so the AVX2 reductions inline through the generic selector search into a function
+// compiled for AVX2
+SIMPLE8B_TARGET_AVX2 __attribute__((flatten)) inline bool EncodeFastPrescanAvx2(const uint64_t *&in,
+                                                                              const uint64_t *const end,
+                                                                              uint64_t *&out)
+{
+    return EncodeFast<uint64_t, FindSelectorPrescan<uint64_t, OrReduceAvx2>>(in, end, out);
+}
+#endif
+
+// runs the pre-scan encode loop with the active reduction kernels, the scalar ones when no vector
+// kernels are available
+inline bool EncodeFastPrescanSimd(const uint64_t *&in, const uint64_t *const end, uint64_t *&out)
+{
+    switch (ActiveSimdLevel())
+    {
+#if defined(SIMPLE8B_X86_SIMD)
+    case SIMPLE8B_SIMD_AVX512:
+    case SIMPLE8B_SIMD_AVX2:
+        return EncodeFastPrescanAvx2(in, end, out);
+#elif defined(SIMPLE8B_NEON_SIMD)
+    case SIMPLE8B_SIMD_NEON:
+        return EncodeFast<uint64_t, FindSelectorPrescan<uint64_t, OrReduceNeon>>(in, end, out);
+#elif defined(SIMPLE8B_WASM_SIMD)
+    case SIMPLE8B_SIMD_WASM128:
+        return EncodeFast<uint64_t, FindSelectorPrescan<uint64_t, OrReduceWasm>>(in, end, out);
+#endif
+    default:
+        return EncodeFast<uint64_t, FindSelectorPrescan<uint64_t, OrReduce<uint64_t>>>(in, end, out);
+    }
+}
+
+// Simple8bEncode with the pre-scan selector search; the output is identical
+template <typename T>
+uint64_t Simple8bEncodePrescan(T *input, uint64_t inputLength, uint64_t *out)
+{
+    const uint64_t *const initout = out;
+    const T *in = input;
+    const T *const end = input + inputLength;
+
+    bool fits;
+    if (sizeof(T) == sizeof(uint64_t))
+    {
+        const uint64_t *in64 = reinterpret_cast<const uint64_t *>(in);
+        fits = EncodeFastPrescanSimd(in64, reinterpret_cast<const uint64_t *>(end), out);
+        in = reinterpret_cast<const T *>(in64);
+    }
+    else
+    {
+        fits = EncodeFast<T, FindSelectorPrescan<T, OrReduce<T>>>(in, end, out);
+    }
+
+    if (!fits || !EncodeCareful(in, end, out))
+        return SIMPLE8B_ERROR_VALUE_TOO_LARGE;
+
+    return out - initout;
+}
+
+/*
+    Profile-guided selector search, for inputs whose words mostly land on one wide selector (eg
+    high-cardinality metrics on selectors 11-14). Every block of SIMPLE8B_PROFILE_BLOCK values is
+    sampled at SIMPLE8B_PROFILE_SAMPLES evenly spaced words, and the encoder then tries the most
+    common selector first: it is the answer when its word holds the next values and the next
+    denser selector's does not, which takes at most 8 values to check. Any other word falls back to
+    FindSelector, so the output is identical to Simple8bEncode. Selectors up to 8 are not tried
+    first: FindSelector settles dense words in one pass anyway.
+*/
+
+const uint64_t SIMPLE8B_PROFILE_BLOCK = 32768;
+const uint32_t SIMPLE8B_PROFILE_SAMPLES = 8;
+
+// most common selector among numSamples words, evenly spaced over [in, end) (at least 240 values)
+template <typename T>
+inline uint32_t SampleSelector(const T *in, const T *const end, uint32_t numSamples)
+{
+    uint32_t counts[16] = {};
+    const uint64_t last = static_cast<uint64_t>(end - in) - 240;
+    const uint64_t stride = last / numSamples + 1;
+    for (uint64_t i = 0; i <= last; i += stride)
+        counts[FindSelectorAhead(in + i)]++;
+    return static_cast<uint32_t>(std::max_element(counts, counts + 16) - counts);
+}
+
+// FindSelectorAhead, trying hint (9-15) first
+template <typename T, uint32_t hint>
+inline uint32_t FindSelectorHinted(const T *n)
+{
+    const uint64_t bits = OrReduce(n, SIMPLE8B_SELECTOR_INTEGERS[hint]);
+    if (bits <= SIMPLE8B_SELECTOR_MAX_VALUE[hint] &&
+        (bits | OrReduce(n + SIMPLE8B_SELECTOR_INTEGERS[hint],
+                         SIMPLE8B_SELECTOR_INTEGERS[hint - 1] - SIMPLE8B_SELECTOR_INTEGERS[hint])) >
+            SIMPLE8B_SELECTOR_MAX_VALUE[hint - 1])
+        return hint;
+    return FindSelectorAhead(n);
+}
+
+// EncodeFast with the selector search specialized for hint
+template <typename T>
+inline bool EncodeFastHinted(const T *&in, const T *const end, uint64_t *&out, uint32_t hint)
+{
+    switch (hint)
+    {
+    case 9:
+        return EncodeFast<T, FindSelectorHinted<T, 9>>(in, end, out);
+    case 10:
+        return EncodeFast<T, FindSelectorHinted<T, 10>>(in, end, out);
+    case 11:
+        return EncodeFast<T, FindSelectorHinted<T, 11>>(in, end, out);
+    case 12:
+        return EncodeFast<T, FindSelectorHinted<T, 12>>(in, end, out);
+    case 13:
+        return EncodeFast<T, FindSelectorHinted<T, 13>>(in, end, out);
+    case 14:
+        return EncodeFast<T, FindSelectorHinted<T, 14>>(in, end, out);
+    case 15:
+        return EncodeFast<T, FindSelectorHinted<T, 15>>(in, end, out);
+    default:
+        return EncodeFast(in, end, out);
+    }
+}
+
+// Simple8bEncode with the profile-guided selector search; the output is identical
+template <typename T>
+uint64_t Simple8bEncodeProfiled(T *input, uint64_t inputLength, uint64_t *out)
+{
+    const uint64_t *const initout = out;
+    const T *in = input;
+    const T *const end = input + inputLength;
+
+    // each block leaves its last (fewer than 240) values to the next one
+    while (end - in >= 240)
+    {
+        const T *const blockEnd = in + std::min<uint64_t>(static_cast<uint64_t>(end - in), SIMPLE8B_PROFILE_BLOCK);
+        if (!EncodeFastHinted(in, blockEnd, out, SampleSelector(in, blockEnd, SIMPLE8B_PROFILE_SAMPLES)))
+            return SIMPLE8B_ERROR_VALUE_TOO_LARGE;
+    }
+    if (!EncodeCareful(in, end, out))
+        return SIMPLE8B_ERROR_VALUE_TOO_LARGE;
+
+    return out - initout;
+}
+
+/*
+    Delta coding, front to back with wraparound arithmetic, so out may be the input or a separate
+    buffer and signed overflow never happens.
+
+    32 and 64-bit elements go through vector kernels. Encoding subtracts each vector shifted up
+    one lane, with the previous vector's last value shifted in. Decoding is an in-register prefix
+    sum: log2(lanes) shift-and-add steps, then a carry vector holding the running total of the
+    vectors before it, which is the only dependency between iterations.
+*/
+
+// out[i] = input[i] - input[i - 1] from position i on, previous being the value before position i
+template <typename U>
+inline void DeltaEncodeTail(const U *input, uint64_t i, uint64_t length, U *out, U previous)
+{
+    for (; i < length; i++)
+    {
+        const U value = input[i];
+        out[i] = static_cast<U>(value - previous);
+        previous = value;
+    }
+}
+
+// out[i] = input[i] + out[i - 1] from position i on, previous being the value before position i
+template <typename U>
+inline void DeltaDecodeTail(const U *input, uint64_t i, uint64_t length, U *out, U previous)
+{
+    for (; i < length; i++)
+    {
+        previous = static_cast<U>(previous + input[i]);
+        out[i] = previous;
+    }
+}
+
+#if defined(SIMPLE8B_X86_SIMD)
+SIMPLE8B_TARGET_AVX2 inline void DeltaEncodeAvx2(const uint32_t *input, uint64_t length, uint32_t *out,
+                                                 uint32_t previous)
+{
+    const __m256i rotate = _mm256_setr_epi32(7, 0, 1, 2, 3, 4, 5, 6);
+    __m256i rotatedPrevious = _mm256_set1_epi32(static_cast<int>(previous));
+    uint64_t i = 0;
+    for (; i + 8 <= length; i += 8)
+    {
+        const __m256i values = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(input + i));
+        const __m256i rotated = _mm256_permutevar8x32_epi32(values, rotate);
+        // read before the store, which overwrites it when encoding in place
+        previous = input[i + 7];
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(out + i),
+                            _mm256_sub_epi32(values, _mm256_blend_epi32(rotated, rotatedPrevious, 0x01)));
+        rotatedPrevious = rotated;
+    }
+    DeltaEncodeTail(input, i, length, out, previous);
+}
+
+SIMPLE8B_TARGET_AVX2 inline void DeltaEncodeAvx2(const uint64_t *input, uint64_t length, uint64_t *out,
+                                                 uint64_t previous)
+{
+    __m256i rotatedPrevious = _mm256_set1_epi64x(static_cast<long long>(previous));
+    uint64_t i = 0;
+    for (; i + 4 <= length; i += 4)
+    {
+        const __m256i values = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(input + i));
+        const __m256i rotated = _mm256_permute4x64_epi64(values, _MM_SHUFFLE(2, 1, 0, 3));
+        previous = input[i + 3];
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(out + i),
+                            _mm256_sub_epi64(values, _mm256_blend_epi32(rotated, rotatedPrevious, 0x03)));
+        rotatedPrevious = rotated;
+    }
+    DeltaEncodeTail(input, i, length, out, previous);
+}
+
+SIMPLE8B_TARGET_AVX2 inline void DeltaDecodeAvx2(const uint32_t *input, uint64_t length, uint32_t *out,
+                                                 uint32_t previous)
+{
+    const __m256i last = _mm256_set1_epi32(7);
+    __m256i carry = _mm256_set1_epi32(static_cast<int>(previous));
+    uint64_t i = 0;
+    for (; i + 8 <= length; i += 8)
+    {
+        __m256i sums = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(input + i));
+        sums = _mm256_add_epi32(sums, _mm256_slli_si256(sums, 4));
+        sums = _mm256_add_epi32(sums, _mm256_slli_si256(sums, 8));
+        // byte shifts stay within 128-bit halves: add the lower half's total to the upper half
+        sums = _mm256_add_epi32(sums, _mm256_shuffle_epi32(_mm256_permute2x128_si256(sums, sums, 0x08), 0xFF));
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(out + i), _mm256_add_epi32(sums, carry));
+        carry = _mm256_add_epi32(carry, _mm256_permutevar8x32_epi32(sums, last));
+    }
+    DeltaDecodeTail(input, i, length, out, (i > 0) ? out[i - 1] : previous);
+}
+
+SIMPLE8B_TARGET_AVX2 inline void DeltaDecodeAvx2(const uint64_t *input, uint64_t length, uint64_t *out,
+                                                 uint64_t previous)
+{
+    __m256i carry = _mm256_set1_epi64x(static_cast<long long>(previous));
+    uint64_t i = 0;
+    for (; i + 4 <= length; i += 4)
+    {
+        __m256i sums = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(input + i));
+        sums = _mm256_add_epi64(sums, _mm256_slli_si256(sums, 8));
+        sums = _mm256_add_epi64(sums, _mm256_blend_epi32(_mm256_setzero_si256(),
+                                                         _mm256_permute4x64_epi64(sums, _MM_SHUFFLE(1, 1, 1, 1)), 0xF0));
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(out + i), _mm256_add_epi64(sums, carry));
+        carry = _mm256_add_epi64(carry, _mm256_permute4x64_epi64(sums, _MM_SHUFFLE(3, 3, 3, 3)));
+    }
+    DeltaDecodeTail(input, i, length, out, (i > 0) ? out[i - 1] : previous);
+}
+#endif
+
+#if defined(SIMPLE8B_NEON_SIMD)
+inline void DeltaEncodeNeon(const uint32_t *input, uint64_t length, uint32_t *out, uint32_t previous)
+{
+    uint32x4_t last = vdupq_n_u32(previous);
+    uint64_t i = 0;
+    for (; i + 4 <= length; i += 4)
+    {
+        const uint32x4_t values = vld1q_u32(input + i);
+        vst1q_u32(out + i, vsubq_u32(values, vextq_u32(last, values, 3)));
+        last = values;
+    }
+    DeltaEncodeTail(input, i, length, out, (i > 0) ? vgetq_lane_u32(last, 3) : previous);
+}
+
+inline void DeltaEncodeNeon(const uint64_t *input, uint64_t length, uint64_t *out, uint64_t previous)
+{
+    uint64x2_t last = vdupq_n_u64(previous);
+    uint64_t i = 0;
+    for (; i + 2 <= length; i += 2)
+    {
+        const uint64x2_t values = vld1q_u64(input + i);
+        vst1q_u64(out + i, vsubq_u64(values, vextq_u64(last, values, 1)));
+        last = values;
+    }
+    DeltaEncodeTail(input, i, length, out, (i > 0) ? vgetq_lane_u64(last, 1) : previous);
+}
+
+inline void DeltaDecodeNeon(const uint32_t *input, uint64_t length, uint32_t *out, uint32_t previous)
+{
+    const uint32x4_t zero = vdupq_n_u32(0);
+    uint32x4_t carry = vdupq_n_u32(previous);
+    uint64_t i = 0;
+    for (; i + 4 <= length; i += 4)
+    {
+        uint32x4_t sums = vld1q_u32(input + i);
+        sums = vaddq_u32(sums, vextq_u32(zero, sums, 3));
+        sums = vaddq_u32(sums, vextq_u32(zero, sums, 2));
+        vst1q_u32(out + i, vaddq_u32(sums, carry));
+        carry = vaddq_u32(carry, vdupq_lane_u32(vget_high_u32(sums), 1));
+    }
+    DeltaDecodeTail(input, i, length, out, (i > 0) ? out[i - 1] : previous);
+}
+
+inline void DeltaDecodeNeon(const uint64_t *input, uint64_t length, uint64_t *out, uint64_t previous)
+{
+    const uint64x2_t zero = vdupq_n_u64(0);
+    uint64x2_t carry = vdupq_n_u64(previous);
+    uint64_t i = 0;
+    for (; i + 2 <= length; i += 2)
+    {
+        uint64x2_t sums = vld1q_u64(input + i);
+        sums = vaddq_u64(sums, vextq_u64(zero, sums, 1));
+        vst1q_u64(out + i, vaddq_u64(sums, carry));
+        carry = vaddq_u64(carry, vdupq_lane_u64(vget_high_u64(sums), 0));
+    }
+    DeltaDecodeTail(input, i, length, out, (i > 0) ? out[i - 1] : previous);
+}
+#endif
+
+#if defined(SIMPLE8B_WASM_SIMD)
+inline void DeltaEncodeWasm(const uint32_t *input, uint64_t length, uint32_t *out, uint32_t previous)
+{
+    v128_t last = wasm_u32x4_splat(previous);
+    uint64_t i = 0;
+    for (; i + 4 <= length; i += 4)
+    {
+        const v128_t values = wasm_v128_load(input + i);
+        wasm_v128_store(out + i, wasm_i32x4_sub(values, wasm_i32x4_shuffle(last, values, 3, 4, 5, 6)));
+        last = values;
+    }
+    DeltaEncodeTail(input, i, length, out, (i > 0) ? wasm_u32x4_extract_lane(last, 3) : previous);
+}
+
+inline void DeltaEncodeWasm(const uint64_t *input, uint64_t length, uint64_t *out, uint64_t previous)
+{
+    v128_t last = wasm_u64x2_splat(previous);
+    uint64_t i = 0;
+    for (; i + 2 <= length; i += 2)
+    {
+        const v128_t values = wasm_v128_load(input + i);
+        wasm_v128_store(out + i, wasm_i64x2_sub(values, wasm_i64x2_shuffle(last, values, 1, 2)));
+        last = values;
+    }
+    DeltaEncodeTail(input, i, length, out, (i > 0) ? wasm_u64x2_extract_lane(last, 1) : previous);
+}
+
+inline void DeltaDecodeWasm(const uint32_t *input, uint64_t length, uint32_t *out, uint32_t previous)
+{
+    const v128_t zero = wasm_u32x4_splat(0);
+    v128_t carry = wasm_u32x4_splat(previous);
+    uint64_t i = 0;
+    for (; i + 4 <= length; i += 4)
+    {
+        v128_t sums = wasm_v128_load(input + i);
+        sums = wasm_i32x4_add(sums, wasm_i32x4_shuffle(zero, sums, 3, 4, 5, 6));
+        sums = wasm_i32x4_add(sums, wasm_i32x4_shuffle(zero, sums, 2, 3, 4, 5));
+        wasm_v128_store(out + i, wasm_i32x4_add(sums, carry));
+        carry = wasm_i32x4_add(carry, wasm_i32x4_shuffle(sums, sums, 3, 3, 3, 3));
+    }
+    DeltaDecodeTail(input, i, length, out, (i > 0) ? out[i - 1] : previous);
+}
+
+inline void DeltaDecodeWasm(const uint64_t *input, uint64_t length, uint64_t *out, uint64_t previous)
+{
+    const v128_t zero = wasm_u64x2_splat(0);
+    v128_t carry = wasm_u64x2_splat(previous);
+    uint64_t i = 0;
+    for (; i + 2 <= length; i += 2)
+    {
+        v128_t sums = wasm_v128_load(input + i);
+        sums = wasm_i64x2_add(sums, wasm_i64x2_shuffle(zero, sums, 1, 2));
+        wasm_v128_store(out + i, wasm_i64x2_add(sums, carry));
+        carry = wasm_i64x2_add(carry, wasm_i64x2_shuffle(sums, sums, 1, 1));
+    }
+    DeltaDecodeTail(input, i, length, out, (i > 0) ? out[i - 1] : previous);
+}
+#endif
+
+// U is uint32_t or uint64_t
+template <typename U>
+inline void DeltaEncodeSimd(const U *input, uint64_t length, U *out, U previous)
+{
+#if defined(SIMPLE8B_X86_SIMD)
+    if (ActiveSimdLevel() >= SIMPLE8B_SIMD_AVX2)
+        return DeltaEncodeAvx2(input, length, out, previous);
+#elif defined(SIMPLE8B_NEON_SIMD)
+    if (ActiveSimdLevel() >= SIMPLE8B_SIMD_NEON)
+        return DeltaEncodeNeon(input, length, out, previous);
+#elif defined(SIMPLE8B_WASM_SIMD)
+    if (ActiveSimdLevel() == SIMPLE8B_SIMD_WASM128)
+        return DeltaEncodeWasm(input, length, out, previous);
+#endif
+    DeltaEncodeTail(input, 0, length, out, previous);
+}
+
+template <typename U>
+inline void DeltaDecodeSimd(const U *input, uint64_t length, U *out, U previous)
+{
+#if defined(SIMPLE8B_X86_SIMD)
+    if (ActiveSimdLevel() >= SIMPLE8B_SIMD_AVX2)
+        return DeltaDecodeAvx2(input, length, out, previous);
+#elif defined(SIMPLE8B_NEON_SIMD)
+    if (ActiveSimdLevel() >= SIMPLE8B_SIMD_NEON)
+        return DeltaDecodeNeon(input, length, out, previous);
+#elif defined(SIMPLE8B_WASM_SIMD)
+    if (ActiveSimdLevel() == SIMPLE8B_SIMD_WASM128)
+        return DeltaDecodeWasm(input, length, out, previous);
+#endif
+    DeltaDecodeTail(input, 0, length, out, previous);
+}
+
+// delta encode of input[0, length) into out, previous being the value before input[0]
+template <typename T>
+inline void DeltaEncodeFrom(const T *input, uint64_t length, T *out, const T previous)
+{
+    typedef typename std::make_unsigned<T>::type U;
+    if (sizeof(T) == sizeof(uint32_t))
+        return DeltaEncodeSimd(reinterpret_cast<const uint32_t *>(input), length, reinterpret_cast<uint32_t *>(out),
+                               static_cast<uint32_t>(previous));
+    if (sizeof(T) == sizeof(uint64_t))
+        return DeltaEncodeSimd(reinterpret_cast<const uint64_t *>(input), length, reinterpret_cast<uint64_t *>(out),
+                               static_cast<uint64_t>(previous));
+    DeltaEncodeTail(reinterpret_cast<const U *>(input), 0, length, reinterpret_cast<U *>(out),
+                    static_cast<U>(previous));
+}
+
+// delta decode of input[0, length) into out, previous being the value before out[0]
+template <typename T>
+inline void DeltaDecodeFrom(const T *input, uint64_t length, T *out, const T previous)
+{
+    typedef typename std::make_unsigned<T>::type U;
+    if (sizeof(T) == sizeof(uint32_t))
+        return DeltaDecodeSimd(reinterpret_cast<const uint32_t *>(input), length, reinterpret_cast<uint32_t *>(out),
+                               static_cast<uint32_t>(previous));
+    if (sizeof(T) == sizeof(uint64_t))
+        return DeltaDecodeSimd(reinterpret_cast<const uint64_t *>(input), length, reinterpret_cast<uint64_t *>(out),
+                               static_cast<uint64_t>(previous));
+    DeltaDecodeTail(reinterpret_cast<const U *>(input), 0, length, reinterpret_cast<U *>(out),
+                    static_cast<U>(previous));
+}
+
+// out[0] = input[0], out[i] = input[i] - input[i - 1]; out may be input
+template <typename T>
+void DeltaEncode(const T *input, uint64_t length, T *out)
+{
+    DeltaEncodeFrom(input, length, out, static_cast<T>(0));
+}
+
+// inverse of DeltaEncode: out[i] = input[0] + ... + input[i]; out may be input
+template <typename T>
+void DeltaDecode(const T *input, uint64_t length, T *out)
+{
+    DeltaDecodeFrom(input, length, out, static_cast<T>(0));
+}
+
+template <typename T>
+void DeltaEncode(T *input, uint64_t length)
+{
+    DeltaEncode(input, length, input);
+}
+
+template <typename T>
+void DeltaDecode(T *input, uint64_t length)
+{
+    DeltaDecode(input, length, input);
+}
+
+template <typename T>
+void ZigZagEncode(T *input, uint64_t length)
+{
+    T shift = (sizeof(T) * 8) - 1; // sizeof * 8 = # of bits
+    for (uint64_t i = 0; i < length; i++)
+    {
+        input[i] = (input[i] << 1LL) ^ (input[i] >> shift);
+    }
+    return;
+}
+
+template <typename T>
+void ZigZagDecode(T *input, uint64_t length)
+{
+    for (uint64_t i = 0; i < length; i++)
+    {
+        input[i] = (input[i] >> 1LL) ^ -(input[i] & 1LL);
+    }
+    return;
+}
+
+/*
+    Fused transform -> Simple8bEncode pipelines (and the reverse for decoding): DeltaEncode ->
+    ZigZagEncode, delta-of-delta and frame-of-reference.
+
+    The transforms run over blocks of SIMPLE8B_FUSED_BLOCK values in an L1-resident staging
+    buffer instead of full passes over the caller's array, and the input is left untouched.
+    Fewer than 240 staged values are carried over to the next block, so the output is identical
+    to running the transform and then Simple8bEncode.
+*/
+
+const uint64_t SIMPLE8B_FUSED_BLOCK = 1024;
+
+// wraparound delta then zigzag of one value, matching DeltaEncode followed by ZigZagEncode. The
+// delta is sign-extended from the width of T, so unsigned types round-trip too
+template <typename T>
+inline T DeltaZigZag(const T value, const T previous)
+{
+    const uint32_t unusedBits = 64 - 8 * sizeof(T);
+    const int64_t delta =
+        static_cast<int64_t>((static_cast<uint64_t>(value) - static_cast<uint64_t>(previous)) << unusedBits) >> unusedBits;
+    return static_cast<T>((static_cast<uint64_t>(delta) << 1) ^ static_cast<uint64_t>(delta >> 63));
+}
+
+// inverse of DeltaZigZag; computed unsigned so the full range of T round-trips
+template <typename T>
+inline T UnZigZagDelta(const T value, const T previous)
+{
+    const uint64_t zigzag = static_cast<uint64_t>(value) & (~0ULL >> (64 - 8 * sizeof(T)));
+    const uint64_t delta = (zigzag >> 1) ^ (0 - (zigzag & 1));
+    return static_cast<T>(static_cast<uint64_t>(previous) + delta);
+}
+
+// Simple8bEncode of the transformed input: transform(position, count, staged) writes the
+// transformed values of input[position, position + count) to staged, one block at a time.
+// Returns false if a transformed value is too wide for a word
+template <typename S, typename F>
+inline bool EncodeStaged(uint64_t inputLength, uint64_t *&out, F transform)
+{
+    const uint64_t *const initout = out;
+    S staged[SIMPLE8B_FUSED_BLOCK + 240];
+    uint64_t numStaged = 0;
+
+    for (uint64_t done = 0; done < inputLength;)
+    {
+        const uint64_t blockLength = std::min<uint64_t>(inputLength - done, SIMPLE8B_FUSED_BLOCK);
+        transform(done, blockLength, staged + numStaged);
+        done += blockLength;
+        numStaged += blockLength;
+
+        StatsTimer timer(&Simple8bStats::packTicks);
+        const S *in = staged;
+        if (!EncodeFast(in, staged + numStaged, out))
+            return false;
+        numStaged = static_cast<uint64_t>(staged + numStaged - in);
+        std::copy(in, in + numStaged, staged);
+    }
+
+    StatsTimer timer(&Simple8bStats::packTicks);
+    const S *in = staged;
+    if (!EncodeCareful(in, staged + numStaged, out))
+        return false;
+    CountStats(&Simple8bStats::encode, initout, static_cast<uint64_t>(out - initout), inputLength, numStaged);
+    return true;
+}
+
+// Simple8bDecode that hands every decoded run of about one block to inverse(position, count,
+// values) while it is still in L1, to undo the transform in place
+template <typename T, typename F>
+inline void DecodeStaged(const uint64_t *&in, uint64_t uncompressedLength, T *out, F inverse)
+{
+    const uint64_t *const initin = in;
+    const T *const end = out + uncompressedLength;
+    const T *const initout = out;
+    T *transformed = out;
+    uint64_t numCareful = 0;
+
+    while (end > out)
+    {
+        {
+            StatsTimer timer(&Simple8bStats::unpackTicks);
+            if (end > out + 240)
+                DecodeFast(in, out, (end - out > static_cast<int64_t>(SIMPLE8B_FUSED_BLOCK + 240))
+                                        ? out + SIMPLE8B_FUSED_BLOCK + 240
+                                        : end);
+            else
+            {
+                numCareful = static_cast<uint64_t>(end - out);
+                DecodeCareful(in, out, end);
+            }
+        }
+
+        inverse(static_cast<uint64_t>(transformed - initout), static_cast<uint64_t>(out - transformed), transformed);
+        transformed = out;
+    }
+    CountStats(&Simple8bStats::decode, initin, static_cast<uint64_t>(in - initin), uncompressedLength, numCareful);
+}
+
+template <typename T>
+uint64_t Simple8bDeltaZigZagEncode(const T *input, uint64_t inputLength, uint64_t *out)
+{
+    const uint64_t *const initout = out;
+    T previous = 0;
+
+    const bool encoded = EncodeStaged<T>(inputLength, out, [&](uint64_t position, uint64_t count, T *staged)
+                                         {
+                                             // delta and zigzag are one expression: timed as delta
+                                             StatsTimer timer(&Simple8bStats::deltaTicks);
+                                             for (uint64_t i = 0; i < count; i++)
+                                             {
+                                                 staged[i] = DeltaZigZag(input[position + i], previous);
+                                                 previous = input[position + i];
+                                             }
+                                         });
+    // a delta too wide for a word stops the encode
+    if (!encoded)
+        return SIMPLE8B_ERROR_VALUE_TOO_LARGE;
+
+    return out - initout;
+}
+
+template <typename T>
+const uint64_t Simple8bDeltaZigZagDecode(uint64_t *input, uint64_t uncompressedLength, T *out)
+{
+    const uint64_t *in = input;
+    T previous = 0;
+
+    // zigzag decode is elementwise; the deltas then go through the prefix-sum kernels
+    DecodeStaged(in, uncompressedLength, out, [&](uint64_t, uint64_t count, T *values)
+                 {
+                     {
+                         StatsTimer timer(&Simple8bStats::zigzagTicks);
+                         for (uint64_t i = 0; i < count; i++)
+                             values[i] = UnZigZagDelta(values[i], static_cast<T>(0));
+                     }
+                     StatsTimer timer(&Simple8bStats::deltaTicks);
+                     DeltaDecodeFrom(values, count, values, previous);
+                     previous = values[count - 1];
+                 });
+
+    return uncompressedLength;
+}
+
+/*
+    Delta-of-delta (as in Gorilla), for near-regular series such as sampling timestamps: the
+    first value, then the first delta, then the change of every delta after it. Steady spacing
+    turns into runs of zeros, which the 240-zero selectors store almost for free.
+*/
+
+// out[0] = input[0], out[1] = input[1] - input[0], out[i] = (input[i] - input[i - 1]) -
+// (input[i - 1] - input[i - 2]); wraps like DeltaEncode, and out may be input
+template <typename T>
+void DeltaOfDeltaEncode(const T *input, uint64_t length, T *out)
+{
+    DeltaEncode(input, length, out);
+    if (length > 1)
+        DeltaEncode(out + 1, length - 1, out + 1);
+}
+
+// inverse of DeltaOfDeltaEncode; out may be input
+template <typename T>
+void DeltaOfDeltaDecode(const T *input, uint64_t length, T *out)
+{
+    if (length == 0)
+        return;
+    out[0] = input[0];
+    DeltaDecode(input + 1, length - 1, out + 1);
+    DeltaDecode(out, length, out);
+}
+
+template <typename T>
+void DeltaOfDeltaEncode(T *input, uint64_t length)
+{
+    DeltaOfDeltaEncode(input, length, input);
+}
+
+template <typename T>
+void DeltaOfDeltaDecode(T *input, uint64_t length)
+{
+    DeltaOfDeltaDecode(input, length, input);
+}
+
+// fused DeltaOfDeltaEncode -> ZigZagEncode -> Simple8bEncode; returns the number of words written
+// or SIMPLE8B_ERROR_VALUE_TOO_LARGE
+template <typename T>
+uint64_t Simple8bDeltaOfDeltaEncode(const T *input, uint64_t inputLength, uint64_t *out)
+{
+    const uint64_t *const initout = out;
+    T previous = 0;
+    T previousDelta = 0;
+
+    const bool encoded = EncodeStaged<T>(inputLength, out, [&](uint64_t position, uint64_t count, T *staged)
+                                         {
+                                             StatsTimer timer(&Simple8bStats::deltaTicks);
+                                             for (uint64_t i = 0; i < count; i++)
+                                             {
+                                                 const T delta = static_cast<T>(static_cast<uint64_t>(input[position + i]) -
+                                                                                static_cast<uint64_t>(previous));
+                                                 staged[i] = DeltaZigZag(delta, previousDelta);
+                                                 previous = input[position + i];
+                                                 // the first value is stored as is, not as a delta
+                                                 previousDelta = (position + i == 0) ? 0 : delta;
+                                             }
+                                         });
+    if (!encoded)
+        return SIMPLE8B_ERROR_VALUE_TOO_LARGE;
+
+    return out - initout;
+}
+
+template <typename T>
+const uint64_t Simple8bDeltaOfDeltaDecode(uint64_t *input, uint64_t uncompressedLength, T *out)
+{
+    const uint64_t *in = input;
+    T previous = 0;
+    T previousDelta = 0;
+
+    DecodeStaged(in, uncompressedLength, out, [&](uint64_t position, uint64_t count, T *values)
+                 {
+                     {
+                         StatsTimer timer(&Simple8bStats::zigzagTicks);
+                         for (uint64_t i = 0; i < count; i++)
+                             values[i] = UnZigZagDelta(values[i], static_cast<T>(0));
+                     }
+                     StatsTimer timer(&Simple8bStats::deltaTicks);
+                     if (position == 0)
+                     {
+                         previous = values[0];
+                         values++;
+                         count--;
+                     }
+                     // two prefix sums: changes of delta -> deltas -> values
+                     DeltaDecodeFrom(values, count, values, previousDelta);
+                     if (count > 0)
+                         previousDelta = values[count - 1];
+                     DeltaDecodeFrom(values, count, values, previous);
+                     if (count > 0)
+                         previous = values[count - 1];
+                 });
+
+    return uncompressedLength;
+}
+
+/*
+    Frame of reference: every block of SIMPLE8B_FUSED_BLOCK values is stored relative to its
+    minimum, so a series that sits far from zero but varies little (eg readings around an
+    offset) costs only the bits of its range. The transformed values are unsigned, which lets
+    signed inputs use the full range of T.
+
+    Fused streams start with one reference word per block (the block's minimum, as the bits of
+    the unsigned type of T), followed by the Simple8b words of the whole transformed series.
+*/
+
+// subtracts the minimum of input[0, length) from every value; returns the minimum (0 if length is 0)
+template <typename T>
+T FrameOfReferenceEncode(const T *input, uint64_t length, typename std::make_unsigned<T>::type *out)
+{
+    typedef typename std::make_unsigned<T>::type U;
+    if (length == 0)
+        return 0;
+    const T reference = *std::min_element(input, input + length);
+    for (uint64_t i = 0; i < length; i++)
+        out[i] = static_cast<U>(static_cast<U>(input[i]) - static_cast<U>(reference));
+    return reference;
+}
+
+// inverse of FrameOfReferenceEncode; out may alias input
+template <typename T>
+void FrameOfReferenceDecode(const typename std::make_unsigned<T>::type *input, uint64_t length, const T reference,
+                            T *out)
+{
+    typedef typename std::make_unsigned<T>::type U;
+    for (uint64_t i = 0; i < length; i++)
+        out[i] = static_cast<T>(static_cast<U>(input[i] + static_cast<U>(reference)));
+}
+
+// reference words at the start of a fused frame-of-reference stream of inputLength values
+SIMPLE8B_INLINE uint64_t Simple8bFrameOfReferenceHeaderWords(uint64_t inputLength)
+{
+    return (inputLength + SIMPLE8B_FUSED_BLOCK - 1) / SIMPLE8B_FUSED_BLOCK;
+}
+
+// fused FrameOfReferenceEncode (per block) -> Simple8bEncode; out needs room for
+// Simple8bFrameOfReferenceHeaderWords(inputLength) + Simple8bMaxCompressedSize(inputLength) words.
+// Returns the number of words written, header included, or SIMPLE8B_ERROR_VALUE_TOO_LARGE
+template <typename T>
+uint64_t Simple8bFrameOfReferenceEncode(const T *input, uint64_t inputLength, uint64_t *out)
+{
+    typedef typename std::make_unsigned<T>::type U;
+    const uint64_t *const initout = out;
+    uint64_t *const references = out;
+    out += Simple8bFrameOfReferenceHeaderWords(inputLength);
+
+    const bool encoded = EncodeStaged<U>(inputLength, out, [&](uint64_t position, uint64_t count, U *staged)
+                                         {
+                                             const T reference = FrameOfReferenceEncode(input + position, count, staged);
+                                             references[position / SIMPLE8B_FUSED_BLOCK] = static_cast<U>(reference);
+                                         });
+    if (!encoded)
+        return SIMPLE8B_ERROR_VALUE_TOO_LARGE;
+
+    return out - initout;
+}
+
+template <typename T>
+const uint64_t Simple8bFrameOfReferenceDecode(uint64_t *input, uint64_t uncompressedLength, T *out)
+{
+    typedef typename std::make_unsigned<T>::type U;
+    const uint64_t *const references = input;
+    const uint64_t *in = input + Simple8bFrameOfReferenceHeaderWords(uncompressedLength);
+
+    // decoded runs do not line up with the blocks, so each run is split at block boundaries
+    DecodeStaged(in, uncompressedLength, reinterpret_cast<U *>(out), [&](uint64_t position, uint64_t count, U *values)
+                 {
+                     while (count > 0)
+                     {
+                         const uint64_t block = position / SIMPLE8B_FUSED_BLOCK;
+                         const uint64_t blockCount = std::min<uint64_t>(count, (block + 1) * SIMPLE8B_FUSED_BLOCK - position);
+                         FrameOfReferenceDecode(values, blockCount, static_cast<T>(references[block]),
+                                                reinterpret_cast<T *>(values));
+                         position += blockCount;
+                         values += blockCount;
+                         count -= blockCount;
+                     }
+                 });
+
+    return uncompressedLength;
+}
+
+/*
+    Sidecar skip index for random access.
+
+    Entry j describes word j * interval: the number of values stored before it and, for
+    streams written by Simple8bDeltaZigZagEncode, the original value just before it, so the
+    running delta can resume there. Every word except the last holds exactly
+    SIMPLE8B_SELECTOR_INTEGERS[selector] values, which is what makes the offsets computable
+    from the selectors alone.
+
+    The index needs room for (numWords + interval - 1) / interval entries.
+*/
+
+struct Simple8bIndexEntry
+{
+    uint64_t word;     // offset of the checkpoint word in the encoded stream
+    uint64_t position; // number of values encoded before the checkpoint word
+    int64_t prefix;    // delta streams: value at position - 1 (0 at the start), otherwise 0
+};
+
+// number of values held by the word at in, given how many were decoded before it
+inline uint64_t GetWordIntegers(const uint64_t *in, uint64_t position, uint64_t uncompressedLength)
+{
+    return std::min<uint64_t>(SIMPLE8B_SELECTOR_INTEGERS[GetSelectorNum(in)], uncompressedLength - position);
+}
+
+// returns the last entry at or before the given value position
+inline const Simple8bIndexEntry *FindIndexEntry(const Simple8bIndexEntry *index, uint64_t numEntries, uint64_t position)
+{
+    const Simple8bIndexEntry *entry = std::upper_bound(
+        index, index + numEntries, position,
+        [](uint64_t value, const Simple8bIndexEntry &e) { return value < e.position; });
+    return entry - 1;
+}
+
+inline uint64_t Simple8bBuildIndex(const uint64_t *input, uint64_t uncompressedLength, uint64_t interval, Simple8bIndexEntry *index)
+{
+    uint64_t numEntries = 0;
+    uint64_t position = 0;
+    for (uint64_t word = 0; position < uncompressedLength; word++)
+    {
+        if (word % interval == 0)
+            index[numEntries++] = {word, position, 0};
+        position += GetWordIntegers(input + word, position, uncompressedLength);
+    }
+    return numEntries;
+}
+
+template <typename T>
+uint64_t Simple8bBuildDeltaZigZagIndex(const uint64_t *input, uint64_t uncompressedLength, uint64_t interval,
+                                       Simple8bIndexEntry *index)
+{
+    const uint64_t *in = input;
+    T scratch[240];
+    T previous = 0;
+    uint64_t numEntries = 0;
+    uint64_t position = 0;
+    for (uint64_t word = 0; position < uncompressedLength; word++)
+    {
+        if (word % interval == 0)
+            index[numEntries++] = {word, position, static_cast<int64_t>(previous)};
+        const uint64_t numIntegers = GetWordIntegers(in, position, uncompressedLength);
+        T *tmp = scratch;
+        UnpackWord(tmp, in);
+        for (uint64_t i = 0; i < numIntegers; i++)
+            previous = UnZigZagDelta(scratch[i], previous);
+        position += numIntegers;
+    }
+    return numEntries;
+}
+
+// decodes values [start, start + count) using an index from Simple8bBuildIndex
+template <typename T>
+const uint64_t Simple8bDecodeRange(uint64_t *input, const Simple8bIndexEntry *index, uint64_t numEntries,
+                                   uint64_t uncompressedLength, uint64_t start, uint64_t count, T *out)
+{
+    if (start >= uncompressedLength)
+        return 0;
+    count = std::min<uint64_t>(count, uncompressedLength - start);
+
+    const Simple8bIndexEntry *entry = FindIndexEntry(index, numEntries, start);
+    const uint64_t *in = input + entry->word;
+    uint64_t position = entry->position;
+    while (position + GetWordIntegers(in, position, uncompressedLength) <= start)
+        position += GetWordIntegers(in++, position, uncompressedLength);
+
+    // the word holding start may begin before it
+    T scratch[240];
+    T *tmp = scratch;
+    const uint64_t numIntegers = GetWordIntegers(in, position, uncompressedLength);
+    UnpackWord(tmp, in);
+    const uint64_t skipped = start - position;
+    const uint64_t first = std::min<uint64_t>(numIntegers - skipped, count);
+    std::copy(scratch + skipped, scratch + skipped + first, out);
+
+    T *rest = out + first;
+    const T *const end = out + count;
+    DecodeFast(in, rest, end);
+    DecodeCareful(in, rest, end);
+    return count;
+}
+
+// decodes original values [start, start + count) of a Simple8bDeltaZigZagEncode stream using an
+// index from Simple8bBuildDeltaZigZagIndex
+template <typename T>
+const uint64_t Simple8bDeltaZigZagDecodeRange(uint64_t *input, const Simple8bIndexEntry *index, uint64_t numEntries,
+                                              uint64_t uncompressedLength, uint64_t start, uint64_t count, T *out)
+{
+    if (start >= uncompressedLength)
+        return 0;
+    count = std::min<uint64_t>(count, uncompressedLength - start);
+
+    const Simple8bIndexEntry *entry = FindIndexEntry(index, numEntries, start);
+    const uint64_t *in = input + entry->word;
+    uint64_t position = entry->position;
+    T previous = static_cast<T>(entry->prefix);
+
+    // words before start only move the running value forward
+    T scratch[240];
+    uint64_t written = 0;
+    do
+    {
+        const uint64_t numIntegers = GetWordIntegers(in, position, uncompressedLength);
+        T *tmp = scratch;
+        UnpackWord(tmp, in);
+        for (uint64_t i = 0; i < numIntegers; i++)
+        {
+            previous = UnZigZagDelta(scratch[i], previous);
+            if (position + i >= start && written < count)
+                out[written++] = previous;
+        }
+        position += numIntegers;
+    } while (position <= start);
+
+    T *rest = out + written;
+    T *transformed = rest;
+    const T *const end = out + count;
+    DecodeFast(in, rest, end);
+    DecodeCareful(in, rest, end);
+    for (; transformed < rest; transformed++)
+    {
+        *transformed = UnZigZagDelta(*transformed, previous);
+        previous = *transformed;
+    }
+    return count;
+}
+
+/*
+    Reusable scratch memory and worker threads.
+
+    The chunked and batch codecs need index arrays and worker threads on every call. Given a
+    Simple8bContext they take both from it: its arena grows to the largest call seen and is then
+    reused, and its workers are started once and parked between calls, so repeated calls of
+    similar sizes make no heap allocations. Without one, each call uses a context of its own.
+    A context serves one call at a time: give each calling thread its own.
+*/
+
+class Simple8bContext
+{
+public:
+    Simple8bContext() : current(0), used(0), generation(0), stopping(false), numHelpers(0), numActive(0),
+                        job(NULL), jobState(NULL), jobTasks(0), next(0) {}
+
+    Simple8bContext(const Simple8bContext &) = delete;
+    Simple8bContext &operator=(const Simple8bContext &) = delete;
+
+    ~Simple8bContext()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        wake.notify_all();
+        for (std::thread &worker : workers)
+            worker.join();
+    }
+
+    // arena words taken by Allocate while a Scope is alive are given back when it ends
+    class Scope
+    {
+    public:
+        explicit Scope(Simple8bContext &context) : context(context), current(context.current), used(context.used) {}
+
+        ~Scope()
+        {
+            context.current = current;
+            context.used = used;
+        }
+
+    private:
+        Simple8bContext &context;
+        const size_t current;
+        const uint64_t used;
+    };
+
+    // numWords words of scratch; blocks are kept once allocated, and a call that outgrows them
+    // adds one twice the size of the last
+    uint64_t *Allocate(uint64_t numWords)
+    {
+        while (current < blocks.size() && blocks[current].size - used < numWords)
+        {
+            current++;
+            used = 0;
+        }
+        if (current == blocks.size())
+        {
+            const uint64_t size = std::max<uint64_t>(numWords, blocks.empty() ? 4096 : 2 * blocks.back().size);
+            blocks.push_back({std::unique_ptr<uint64_t[]>(new uint64_t[size]), size});
+            used = 0;
+        }
+        uint64_t *const words = blocks[current].words.get() + used;
+        used += numWords;
+        return words;
+    }
+
+    // runs task(i) for every i in [0, numTasks) on up to numThreads threads (0 = one per core),
+    // the calling thread included
+    template <typename F>
+    void Run(uint64_t numTasks, uint32_t numThreads, F task)
+    {
+        if (numThreads == 0)
+            numThreads = std::max<uint32_t>(std::thread::hardware_concurrency(), 1);
+        numThreads = static_cast<uint32_t>(std::min<uint64_t>(numThreads, numTasks));
+        if (numThreads <= 1)
+        {
+            for (uint64_t i = 0; i < numTasks; i++)
+                task(i);
+            return;
+        }
+
+        while (workers.size() < numThreads - 1)
+            workers.emplace_back(&Simple8bContext::Work, this);
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            job = [](void *state, uint64_t i) { (*static_cast<F *>(state))(i); };
+            jobState = &task;
+            jobTasks = numTasks;
+            next = 0;
+            numHelpers = numThreads - 1;
+            generation++;
+        }
+        wake.notify_all();
+        Drain();
+
+        // workers waking up after this point skip the job
+        std::unique_lock<std::mutex> lock(mutex);
+        numHelpers = 0;
+        done.wait(lock, [this]() { return numActive == 0; });
+    }
+
+private:
+    struct Block
+    {
+        std::unique_ptr<uint64_t[]> words;
+        uint64_t size;
+    };
+
+    void Drain()
+    {
+        for (uint64_t i = next++; i < jobTasks; i = next++)
+            job(jobState, i);
+    }
+
+    void Work()
+    {
+        uint64_t seen = 0;
+        std::unique_lock<std::mutex> lock(mutex);
+        for (;;)
+        {
+            wake.wait(lock, [&]() { return stopping || generation != seen; });
+            if (stopping)
+                return;
+            seen = generation;
+            if (numHelpers == 0)
+                continue;
+            numHelpers--;
+            numActive++;
+            lock.unlock();
+            Drain();
+            lock.lock();
+            if (--numActive == 0)
+                done.notify_one();
+        }
+    }
+
+    std::vector<Block> blocks;
+    size_t current; // block Allocate takes words from
+    uint64_t used;  // words of the current block already taken
+
+    std::vector<std::thread> workers;
+    std::mutex mutex;
+    std::condition_variable wake; // a job was posted, or the context is going away
+    std::condition_variable done; // the last worker on a job has finished
+    uint64_t generation;          // number of jobs posted
+    bool stopping;
+    uint32_t numHelpers; // workers still wanted on the current job
+    uint32_t numActive;  // workers running the current job
+    void (*job)(void *, uint64_t);
+    void *jobState;
+    uint64_t jobTasks;
+    std::atomic<uint64_t> next; // next task of the current job to claim
+};
+
+SIMPLE8B_INLINE Simple8bContext *Simple8bContextCreate()
+{
+    return new Simple8bContext();
+}
+
+SIMPLE8B_INLINE void Simple8bContextDestroy(Simple8bContext *context)
+{
+    delete context;
+}
+
+/*
+    Chunked container for parallel encoding/decoding of very large arrays.
+
+    Layout, in 64-bit words:
+        [0]                     number of chunks
+        [1]                     total number of values
+        [2 + 2i], [3 + 2i]      chunk i: word offset of its Simple8b stream from the start of
+                                the container, and the number of values it holds
+        ...                     the chunk streams, back to back
+
+    Chunks are independent Simple8b streams, so they can be encoded and decoded concurrently.
+    Worker threads claim chunks from a shared counter, which keeps them busy when some chunks
+    compress faster than others. The workers and the decoder's scratch come from the optional
+    Simple8bContext.
+*/
+
+const uint64_t SIMPLE8B_CHUNKED_HEADER_WORDS = 2;
+
+// output capacity, in words, needed by Simple8bEncodeChunked
+inline uint64_t Simple8bChunkedMaxWords(uint64_t inputLength, uint64_t chunkLength)
+{
+    const uint64_t numChunks = (inputLength + chunkLength - 1) / chunkLength;
+    return SIMPLE8B_CHUNKED_HEADER_WORDS + 2 * numChunks + inputLength;
+}
+
+// number of values stored in a chunked container, ie the output length Simple8bDecodeChunked needs
+inline uint64_t Simple8bChunkedLength(const uint64_t *input)
+{
+    return input[1];
+}
+
+template <typename T>
+uint64_t Simple8bEncodeChunked(const T *input, uint64_t inputLength, uint64_t chunkLength, uint32_t numThreads,
+                               uint64_t *out, Simple8bContext *context = NULL)
+{
+    Simple8bContext local;
+    Simple8bContext &shared = (context != NULL) ? *context : local;
+    const uint64_t numChunks = (inputLength + chunkLength - 1) / chunkLength;
+    uint64_t *const directory = out + SIMPLE8B_CHUNKED_HEADER_WORDS;
+    std::atomic<bool> tooLarge(false);
+    uint64_t *const streams = directory + 2 * numChunks;
+    out[0] = numChunks;
+    out[1] = inputLength;
+
+    // a word holds at least one value, so chunk i fits in the slot starting at its first value;
+    // the streams are encoded there concurrently, then packed together
+    shared.Run(numChunks, numThreads, [&](uint64_t i)
+               {
+                   const T *in = input + i * chunkLength;
+                   const T *const end = std::min(in + chunkLength, input + inputLength);
+                   uint64_t *chunkOut = streams + i * chunkLength;
+                   if (!EncodeFast(in, end, chunkOut) || !EncodeCareful(in, end, chunkOut))
+                       tooLarge = true;
+                   directory[2 * i] = static_cast<uint64_t>(chunkOut - (streams + i * chunkLength));
+                   directory[2 * i + 1] = static_cast<uint64_t>(end - (input + i * chunkLength));
+               });
+    if (tooLarge)
+        return SIMPLE8B_ERROR_VALUE_TOO_LARGE;
+
+    uint64_t *packed = streams;
+    for (uint64_t i = 0; i < numChunks; i++)
+    {
+        const uint64_t numWords = directory[2 * i];
+        std::copy(streams + i * chunkLength, streams + i * chunkLength + numWords, packed);
+        directory[2 * i] = static_cast<uint64_t>(packed - out);
+        packed += numWords;
+    }
+
+    return packed - out;
+}
+
+template <typename T>
+const uint64_t Simple8bDecodeChunked(uint64_t *input, T *out, uint32_t numThreads, Simple8bContext *context = NULL)
+{
+    Simple8bContext local;
+    Simple8bContext &shared = (context != NULL) ? *context : local;
+    const Simple8bContext::Scope scope(shared);
+    const uint64_t numChunks = input[0];
+    const uint64_t *const directory = input + SIMPLE8B_CHUNKED_HEADER_WORDS;
+
+    uint64_t *const positions = shared.Allocate(numChunks);
+    uint64_t position = 0;
+    for (uint64_t i = 0; i < numChunks; i++)
+    {
+        positions[i] = position;
+        position += directory[2 * i + 1];
+    }
+
+    // chunks write disjoint ranges of out: the fast loop stops 240 values short of a chunk's end,
+    // so the vector kernels never spill into the next chunk
+    shared.Run(numChunks, numThreads, [&](uint64_t i)
+               {
+                   const uint64_t *in = input + directory[2 * i];
+                   T *chunkOut = out + positions[i];
+                   const T *const end = chunkOut + directory[2 * i + 1];
+                   DecodeFast(in, chunkOut, end);
+                   DecodeCareful(in, chunkOut, end);
+               });
+
+    return position;
+}
+
+/*
+    Batch encoding and decoding of many short series in one call.
+
+    The streams of all series go back to back into one arena of words, offsets[i] being the
+    word offset of series i's stream and offsets[numSeries] the total, and decode back to back
+    into one arena of values. Series are split into tasks of consecutive series holding about
+    SIMPLE8B_BATCH_TASK_VALUES values between them, run on up to numThreads threads (1 runs
+    everything on the calling thread, 0 uses one thread per core). The index arrays and workers
+    come from the optional Simple8bContext.
+
+    Short series spend all their time in the tail loops, and decoding their last words through
+    a scratch buffer would cost more than the unpacking. Instead, the words of a series decode
+    straight into the arena while the task has 240 values of room past the series' end: what a
+    word spills past the end lands on the next series of the task, which is decoded afterwards.
+    Only the series at the very end of a task go through the scratch buffer.
+*/
+
+const uint64_t SIMPLE8B_BATCH_TASK_VALUES = 1 << 16;
+
+// splits the series into tasks: fills firstSeries and firstValue, taken from the context's arena,
+// with the first series and first value of every task, each followed by the totals for numSeries;
+// returns the number of tasks
+inline uint64_t SplitBatch(const uint64_t *lengths, uint64_t numSeries, uint32_t numThreads, Simple8bContext &context,
+                           uint64_t *&firstSeries, uint64_t *&firstValue)
+{
+    // every task but the last holds at least SIMPLE8B_BATCH_TASK_VALUES values
+    uint64_t total = 0;
+    for (uint64_t i = 0; i < numSeries; i++)
+        total += lengths[i];
+    const uint64_t maxTasks = (numThreads == 1) ? 1 : total / SIMPLE8B_BATCH_TASK_VALUES + 1;
+    firstSeries = context.Allocate(maxTasks + 1);
+    firstValue = context.Allocate(maxTasks + 1);
+
+    uint64_t numTasks = 0;
+    uint64_t position = 0;
+    firstSeries[0] = 0;
+    firstValue[0] = 0;
+    for (uint64_t i = 0; i < numSeries; i++)
+    {
+        if (numThreads != 1 && position - firstValue[numTasks] >= SIMPLE8B_BATCH_TASK_VALUES)
+        {
+            numTasks++;
+            firstSeries[numTasks] = i;
+            firstValue[numTasks] = position;
+        }
+        position += lengths[i];
+    }
+    numTasks++;
+    firstSeries[numTasks] = numSeries;
+    firstValue[numTasks] = position;
+    return numTasks;
+}
+
+// encodes numSeries series into out, which needs room for as many words as there are values in
+// total (see Simple8bMaxCompressedSize), and fills the numSeries + 1 offsets; returns the number
+// of words written, or SIMPLE8B_ERROR_VALUE_TOO_LARGE
+template <typename T>
+uint64_t Simple8bEncodeBatch(const T *const *inputs, const uint64_t *lengths, uint64_t numSeries, uint64_t *out,
+                             uint64_t *offsets, uint32_t numThreads = 1, Simple8bContext *context = NULL)
+{
+    Simple8bContext local;
+    Simple8bContext &shared = (context != NULL) ? *context : local;
+    const Simple8bContext::Scope scope(shared);
+    uint64_t *firstSeries;
+    uint64_t *firstValue;
+    const uint64_t numTasks = SplitBatch(lengths, numSeries, numThreads, shared, firstSeries, firstValue);
+    uint64_t *const taskWords = shared.Allocate(numTasks);
+    std::atomic<bool> tooLarge(false);
+
+    // a word holds at least one value, so task t fits in the slot starting at its first value;
+    // the tasks are encoded there concurrently, then packed together
+    shared.Run(numTasks, numThreads, [&](uint64_t t)
+               {
+                   uint64_t *const slot = out + firstValue[t];
+                   uint64_t *taskOut = slot;
+                   for (uint64_t i = firstSeries[t]; i < firstSeries[t + 1]; i++)
+                   {
+                       const T *in = inputs[i];
+                       const T *const end = in + lengths[i];
+                       offsets[i] = static_cast<uint64_t>(taskOut - slot);
+                       if (!EncodeFast(in, end, taskOut) || !EncodeCareful(in, end, taskOut))
+                       {
+                           tooLarge = true;
+                           return;
+                       }
+                   }
+                   taskWords[t] = static_cast<uint64_t>(taskOut - slot);
+               });
+    if (tooLarge)
+        return SIMPLE8B_ERROR_VALUE_TOO_LARGE;
+
+    uint64_t packed = 0;
+    for (uint64_t t = 0; t < numTasks; t++)
+    {
+        const uint64_t *const slot = out + firstValue[t];
+        if (packed != firstValue[t])
+            std::copy(slot, slot + taskWords[t], out + packed);
+        for (uint64_t i = firstSeries[t]; i < firstSeries[t + 1]; i++)
+            offsets[i] += packed;
+        packed += taskWords[t];
+    }
+    offsets[numSeries] = packed;
+
+    return packed;
+}
+
+// decodes the numSeries streams of a Simple8bEncodeBatch arena back to back into out; returns
+// the total number of values
+template <typename T>
+const uint64_t Simple8bDecodeBatch(uint64_t *input, const uint64_t *offsets, const uint64_t *lengths,
+                                   uint64_t numSeries, T *out, uint32_t numThreads = 1,
+                                   Simple8bContext *context = NULL)
+{
+    Simple8bContext local;
+    Simple8bContext &shared = (context != NULL) ? *context : local;
+    const Simple8bContext::Scope scope(shared);
+    uint64_t *firstSeries;
+    uint64_t *firstValue;
+    const uint64_t numTasks = SplitBatch(lengths, numSeries, numThreads, shared, firstSeries, firstValue);
+
+    shared.Run(numTasks, numThreads, [&](uint64_t t)
+               {
+                   const T *const taskEnd = out + firstValue[t + 1];
+                   T *seriesOut = out + firstValue[t];
+                   for (uint64_t i = firstSeries[t]; i < firstSeries[t + 1]; i++)
+                   {
+                       const uint64_t *in = input + offsets[i];
+                       const T *const end = seriesOut + lengths[i];
+                       T *decoded = seriesOut;
+                       // with 240 values of room past the end, the fast loop runs to the end
+                       if (taskEnd - end >= 240)
+                       {
+                           DecodeFast(in, decoded, end + 240);
+                       }
+                       else
+                       {
+                           DecodeFast(in, decoded, end);
+                           DecodeCareful(in, decoded, end);
+                       }
+                       seriesOut += lengths[i];
+                   }
+               });
+
+    return firstValue[numTasks];
+}
+
+/*
+    Streaming encoder for append-only ingest.
+
+    Values are held back only until their word's selector is final, ie until the search in
+    FindSelector would return with the values seen so far. Pending values always fit in one
+    word of the current candidate selector, so they are kept packed in a single payload word
+    and the whole state is 16 bytes per series.
+
+    Appending values one by one and then calling Close produces exactly the words Simple8bEncode
+    writes for the same array. Flush makes everything appended so far decodable without ending
+    the stream, by coding the pending values in whole words, at some cost in density.
+*/
+
+// most words a single Append can emit: each emitted word moves the candidate selector up
+const uint32_t SIMPLE8B_STREAM_MAX_APPEND_WORDS = 16;
+
+// returned by Append instead of a word count for a value above SIMPLE8B_MAX_VALUE
+const uint32_t SIMPLE8B_STREAM_ERROR_VALUE_TOO_LARGE = ~0U;
+
+// runs the FindSelector search over the values available so far; returns the number of values
+// the chosen selector codes once the choice is final, or 0 while more values could still change it
+inline uint32_t TrySelectFinal(const uint64_t *n, uint64_t available, uint32_t &selector)
+{
+    uint32_t candidate = 0;
+    uint64_t bitsSeen = 0;
+    for (uint64_t i = 1; i <= available; i++)
+    {
+        bitsSeen |= n[i - 1];
+        if (bitsSeen > SIMPLE8B_SELECTOR_MAX_VALUE[candidate])
+        {
+            const uint32_t needed = SIMPLE8B_WIDTH_SELECTOR[GetBitWidth(bitsSeen)];
+            const uint32_t last = GetLastSelectorHolding(i);
+            if (last < needed)
+            {
+                selector = last + 1;
+                return SIMPLE8B_SELECTOR_INTEGERS[selector];
+            }
+            candidate = needed;
+        }
+        if (i == SIMPLE8B_SELECTOR_INTEGERS[candidate])
+        {
+            selector = candidate;
+            return static_cast<uint32_t>(i);
+        }
+    }
+    selector = candidate;
+    return 0;
+}
+
+// packs numIntegers values into one word, left-aligned after the selector like PackCareful
+inline uint64_t PackValues(const uint32_t selector, const uint64_t *n, const uint32_t numIntegers)
+{
+    uint64_t word = selector;
+    const uint32_t numBitsPerInt = SIMPLE8B_SELECTOR_INT_BITS[selector];
+    for (uint32_t i = 0; i < numIntegers; i++)
+        WriteBits(&word, n[i], numBitsPerInt);
+    return word << (64 - SIMPLE8B_SELECTOR_BITS - numBitsPerInt * numIntegers);
+}
+
+template <typename T>
+class Simple8bStreamEncoder
+{
+public:
+    Simple8bStreamEncoder() : payload(0), numPending(0), selector(0) {}
+
+    // adds one value; returns the number of words written to out, which needs room for
+    // SIMPLE8B_STREAM_MAX_APPEND_WORDS words, or SIMPLE8B_STREAM_ERROR_VALUE_TOO_LARGE with the
+    // encoder left as it was
+    uint32_t Append(const T value, uint64_t *out)
+    {
+        const uint64_t v = static_cast<uint64_t>(value);
+        if (v <= SIMPLE8B_SELECTOR_MAX_VALUE[selector])
+        {
+            const uint32_t numBitsPerInt = SIMPLE8B_SELECTOR_INT_BITS[selector];
+            payload = (payload << numBitsPerInt) | v;
+            if (++numPending < SIMPLE8B_SELECTOR_INTEGERS[selector])
+                return 0;
+            // selectors 8 and 9 leave 4 bits unused at the bottom of the word
+            out[0] = (static_cast<uint64_t>(selector) << (64 - SIMPLE8B_SELECTOR_BITS)) |
+                     (payload << (64 - SIMPLE8B_SELECTOR_BITS - numBitsPerInt * numPending));
+            Reset();
+            return 1;
+        }
+
+        // the value widens the word: rerun the selector search over everything pending. The
+        // candidate selector never reaches 15, so values too wide for any word all end up here
+        if (v > SIMPLE8B_MAX_VALUE)
+            return SIMPLE8B_STREAM_ERROR_VALUE_TOO_LARGE;
+        uint64_t values[240];
+        const uint32_t numValues = TakePending(values);
+        values[numValues] = v;
+        return Emit(values, numValues + 1, out);
+    }
+
+    // writes the pending values as whole words, so the stream written so far decodes on its
+    // own; returns the number of words written (at most SIMPLE8B_STREAM_MAX_APPEND_WORDS)
+    uint32_t Flush(uint64_t *out)
+    {
+        uint64_t values[240];
+        const uint32_t numValues = TakePending(values);
+        uint32_t numWords = 0;
+        for (uint32_t done = 0; done < numValues; numWords++)
+        {
+            // densest selector whose whole word is filled by the values left
+            uint32_t s = 0;
+            while (SIMPLE8B_SELECTOR_INTEGERS[s] > numValues - done ||
+                   *std::max_element(values + done, values + done + SIMPLE8B_SELECTOR_INTEGERS[s]) >
+                       SIMPLE8B_SELECTOR_MAX_VALUE[s])
+                s++;
+            out[numWords] = PackValues(s, values + done, SIMPLE8B_SELECTOR_INTEGERS[s]);
+            done += SIMPLE8B_SELECTOR_INTEGERS[s];
+        }
+        return numWords;
+    }
+
+    // ends the stream, coding the pending values like the tail of Simple8bEncode; returns the
+    // number of words written (0 or 1). The encoder can then start a new stream
+    uint32_t Close(uint64_t *out)
+    {
+        if (numPending == 0)
+            return 0;
+        uint64_t values[240];
+        const uint32_t s = selector;
+        const uint32_t numValues = TakePending(values);
+        out[0] = PackValues(s, values, numValues);
+        return 1;
+    }
+
+private:
+    void Reset()
+    {
+        payload = 0;
+        numPending = 0;
+        selector = 0;
+    }
+
+    // unpacks the pending values, oldest first, and clears them
+    uint32_t TakePending(uint64_t *values)
+    {
+        const uint32_t numBitsPerInt = SIMPLE8B_SELECTOR_INT_BITS[selector];
+        const uint64_t mask = (1ULL << numBitsPerInt) - 1;
+        const uint32_t numValues = numPending;
+        for (uint32_t k = 0; k < numValues; k++)
+            values[k] = (payload >> ((numValues - 1 - k) * numBitsPerInt)) & mask;
+        Reset();
+        return numValues;
+    }
+
+    // writes every word made final by the given values and keeps the rest pending
+    uint32_t Emit(const uint64_t *values, uint32_t numValues, uint64_t *out)
+    {
+        uint32_t numWords = 0;
+        for (;;)
+        {
+            uint32_t s;
+            const uint32_t numCoded = TrySelectFinal(values, numValues, s);
+            if (numCoded == 0)
+            {
+                selector = static_cast<uint8_t>(s);
+                for (uint32_t k = 0; k < numValues; k++)
+                    payload = (payload << SIMPLE8B_SELECTOR_INT_BITS[s]) | values[k];
+                numPending = static_cast<uint8_t>(numValues);
+                return numWords;
+            }
+            out[numWords++] = PackValues(s, values, numCoded);
+            values += numCoded;
+            numValues -= numCoded;
+            if (numValues == 0)
+                return numWords;
+        }
+    }
+
+    uint64_t payload;   // pending values packed at the candidate selector's width, oldest highest
+    uint8_t numPending; // values held back, always fewer than the candidate selector's word holds
+    uint8_t selector;   // candidate selector for the pending values
+};
+
+/*
+    Pull-based decoder: yields the values of a Simple8b stream on demand, so callers can fold
+    them into aggregates without materializing the whole array. Memory use is one word's worth
+    of values, whatever the stream length.
+*/
+
+template <typename T>
+class Simple8bDecoder
+{
+public:
+    Simple8bDecoder(const uint64_t *input, uint64_t uncompressedLength)
+        : in(input), numUndecoded(uncompressedLength), bufferPos(0), bufferLength(0) {}
+
+    // values not returned yet
+    uint64_t Remaining() const
+    {
+        return numUndecoded + (bufferLength - bufferPos);
+    }
+
+    // writes up to max values to dst; returns how many were written, 0 once the stream is exhausted
+    uint64_t NextBlock(T *dst, uint64_t max)
+    {
+        max = std::min<uint64_t>(max, Remaining());
+        uint64_t written = TakeBuffered(dst, max);
+
+        // whole words go straight to dst while they cannot be the stream's last, partial, word
+        if (written < max)
+        {
+            T *out = dst + written;
+            DecodeFast(in, out, out + std::min<uint64_t>(max - written, numUndecoded));
+            numUndecoded -= static_cast<uint64_t>(out - (dst + written));
+            written = static_cast<uint64_t>(out - dst);
+        }
+        while (written < max)
+        {
+            Refill();
+            written += TakeBuffered(dst + written, max - written);
+        }
+        return written;
+    }
+
+    // reads the next value; returns false once the stream is exhausted
+    bool Next(T &value)
+    {
+        if (bufferPos == bufferLength)
+        {
+            if (numUndecoded == 0)
+                return false;
+            Refill();
+        }
+        value = buffer[bufferPos++];
+        return true;
+    }
+
+private:
+    uint64_t TakeBuffered(T *dst, uint64_t max)
+    {
+        const uint64_t n = std::min<uint64_t>(bufferLength - bufferPos, max);
+        std::copy(buffer + bufferPos, buffer + bufferPos + n, dst);
+        bufferPos += static_cast<uint32_t>(n);
+        return n;
+    }
+
+    void Refill()
+    {
+        T *tmp = buffer;
+        UnpackWord(tmp, in);
+        bufferLength = static_cast<uint32_t>(std::min<uint64_t>(static_cast<uint64_t>(tmp - buffer), numUndecoded));
+        bufferPos = 0;
+        numUndecoded -= bufferLength;
+    }
+
+    const uint64_t *in;
+    uint64_t numUndecoded; // values still packed in the words from in onwards
+    uint32_t bufferPos;
+    uint32_t bufferLength;
+    T buffer[240];
+};
+
+/*
+    Aggregates computed on the packed words, without decoding the stream.
+
+    Zero-run words (selectors 0 and 1) cost O(1). Full words of 1-8 bit integers are summed
+    SWAR-style, with one popcount per bit position instead of one extraction per integer.
+    Simple8bMax skips every word whose selector bound cannot beat the running maximum.
+
+    The count of values is the stream's uncompressedLength. For a DeltaEncode stream,
+    Simple8bSum is the stream's last value; Simple8bDeltaZigZagSum gives the same for
+    Simple8bDeltaZigZagEncode streams, and minus the first value that is last - first.
+*/
+
+// bit 0 of every integer slot in a word, indexed by selector
+constexpr uint64_t SIMPLE8B_SELECTOR_LOW_BITS[16] = {
+    0x0000000000000000ULL, 0x0000000000000000ULL, 0x0FFFFFFFFFFFFFFFULL, 0x0555555555555555ULL,
+    0x0249249249249249ULL, 0x0111111111111111ULL, 0x0084210842108421ULL, 0x0041041041041041ULL,
+    0x0020408102040810ULL, 0x0010101010101010ULL, 0x0004010040100401ULL, 0x0001001001001001ULL,
+    0x0000200040008001ULL, 0x0000010000100001ULL, 0x0000000040000001ULL, 0x0000000000000001ULL};
+
+// widest integers still summed SWAR-style rather than extracted one by one
+const uint32_t SIMPLE8B_SWAR_MAX_BITS = 8;
+
+// sum of every integer slot in a word
+inline uint64_t SumWordSwar(const uint64_t word, const uint32_t selector)
+{
+    const uint64_t lowBits = SIMPLE8B_SELECTOR_LOW_BITS[selector];
+    uint64_t sum = 0;
+    for (uint32_t j = 0; j < SIMPLE8B_SELECTOR_INT_BITS[selector]; j++)
+        sum += static_cast<uint64_t>(GetPopCount(word & (lowBits << j))) << j;
+    return sum;
+}
+
+// integer k of a word
+inline uint64_t GetWordInteger(const uint64_t word, const uint32_t selector, const uint32_t k)
+{
+    const uint32_t numBitsPerInt = SIMPLE8B_SELECTOR_INT_BITS[selector];
+    return (word >> (64 - SIMPLE8B_SELECTOR_BITS - numBitsPerInt - k * numBitsPerInt)) &
+           ((1ULL << numBitsPerInt) - 1);
+}
+
+// wrapping sum of the values
+SIMPLE8B_INLINE uint64_t Simple8bSum(const uint64_t *input, uint64_t uncompressedLength)
+{
+    uint64_t sum = 0;
+    for (uint64_t position = 0; position < uncompressedLength; input++)
+    {
+        const uint32_t selector = GetSelectorNum(input);
+        const uint32_t numIntegers = static_cast<uint32_t>(GetWordIntegers(input, position, uncompressedLength));
+        position += numIntegers;
+        if (selector < 2)
+            continue;
+        if (SIMPLE8B_SELECTOR_INT_BITS[selector] <= SIMPLE8B_SWAR_MAX_BITS &&
+            numIntegers == SIMPLE8B_SELECTOR_INTEGERS[selector])
+        {
+            sum += SumWordSwar(*input, selector);
+            continue;
+        }
+        for (uint32_t k = 0; k < numIntegers; k++)
+            sum += GetWordInteger(*input, selector, k);
+    }
+    return sum;
+}
+
+// largest value, 0 for an empty stream
+SIMPLE8B_INLINE uint64_t Simple8bMax(const uint64_t *input, uint64_t uncompressedLength)
+{
+    uint64_t max = 0;
+    for (uint64_t position = 0; position < uncompressedLength; input++)
+    {
+        const uint32_t selector = GetSelectorNum(input);
+        const uint32_t numIntegers = static_cast<uint32_t>(GetWordIntegers(input, position, uncompressedLength));
+        position += numIntegers;
+        if ((1ULL << SIMPLE8B_SELECTOR_INT_BITS[selector]) - 1 <= max)
+            continue;
+        for (uint32_t k = 0; k < numIntegers; k++)
+            max = std::max(max, GetWordInteger(*input, selector, k));
+    }
+    return max;
+}
+
+// smallest value, UINT64_MAX for an empty stream
+SIMPLE8B_INLINE uint64_t Simple8bMin(const uint64_t *input, uint64_t uncompressedLength)
+{
+    uint64_t min = ~0ULL;
+    for (uint64_t position = 0; position < uncompressedLength && min > 0; input++)
+    {
+        const uint32_t selector = GetSelectorNum(input);
+        const uint32_t numIntegers = static_cast<uint32_t>(GetWordIntegers(input, position, uncompressedLength));
+        position += numIntegers;
+        for (uint32_t k = 0; k < numIntegers; k++)
+            min = std::min(min, GetWordInteger(*input, selector, k));
+    }
+    return min;
+}
+
+// wrapping sum of the zigzag-decoded values of a Simple8bDeltaZigZagEncode stream of int64_t,
+// which is its last original value
+SIMPLE8B_INLINE int64_t Simple8bDeltaZigZagSum(const uint64_t *input, uint64_t uncompressedLength)
+{
+    uint64_t sum = 0;
+    for (uint64_t position = 0; position < uncompressedLength; input++)
+    {
+        const uint32_t selector = GetSelectorNum(input);
+        const uint32_t numBitsPerInt = SIMPLE8B_SELECTOR_INT_BITS[selector];
+        const uint32_t numIntegers = static_cast<uint32_t>(GetWordIntegers(input, position, uncompressedLength));
+        position += numIntegers;
+        if (selector < 2)
+            continue;
+        if (numBitsPerInt <= SIMPLE8B_SWAR_MAX_BITS && numIntegers == SIMPLE8B_SELECTOR_INTEGERS[selector])
+        {
+            // even z decodes to z / 2 and odd z to -(z + 1) / 2, so the word's sum is
+            // (total - 2 * oddTotal - numOdd) / 2; multiplying spreads each odd slot's low bit over the slot
+            const uint64_t odd = *input & SIMPLE8B_SELECTOR_LOW_BITS[selector];
+            const uint64_t oddSlots = odd * ((1ULL << numBitsPerInt) - 1);
+            const int64_t total = static_cast<int64_t>(SumWordSwar(*input, selector));
+            const int64_t oddTotal = static_cast<int64_t>(SumWordSwar(*input & oddSlots, selector));
+            sum += static_cast<uint64_t>((total - 2 * oddTotal - GetPopCount(odd)) / 2);
+            continue;
+        }
+        for (uint32_t k = 0; k < numIntegers; k++)
+        {
+            const uint64_t zigzag = GetWordInteger(*input, selector, k);
+            sum += (zigzag >> 1) ^ (0 - (zigzag & 1));
+        }
+    }
+    return static_cast<int64_t>(sum);
+}
+
+/*
+    Filters evaluated on the packed words: the values in [min, max] are selected, and written
+    either as a bitmap (bit i % 64 of word i / 64 set when value i matches, with room for
+    (uncompressedLength + 63) / 64 words) or as a list of positions, in order. Each returns
+    the number of values selected. Greater, Less and Equal are the ranges they stand for.
+
+    A word's selector bounds its values by 2^bits - 1, so most words are settled from the
+    selector alone: skipped when min is above the bound, taken whole when min is 0 and max
+    reaches it. Zero-run words (selectors 0 and 1) are always settled this way, in O(1). The
+    other words hold at most 60 values, which are unpacked and compared in vector lanes into
+    one match mask per word.
+*/
+
+// bit j set when values[j] - min <= span, ie values[j] in [min, min + span], for up to 60 values
+// (the vector kernels read them in whole vectors, from a scratch buffer of 240)
+inline uint64_t MatchRange(const uint64_t *values, uint32_t numIntegers, uint64_t min, uint64_t span)
+{
+    uint64_t mask = 0;
+    for (uint32_t j = 0; j < numIntegers; j++)
+        mask |= static_cast<uint64_t>(values[j] - min <= span) << j;
+    return mask;
+}
+
+#if defined(SIMPLE8B_X86_SIMD)
+SIMPLE8B_TARGET_AVX2 inline uint64_t MatchRangeAvx2(const uint64_t *values, uint32_t numIntegers, uint64_t min,
+                                                    uint64_t span)
+{
+    // unsigned compare through the signed one, with the sign bits of both sides flipped
+    const __m256i sign = _mm256_set1_epi64x(INT64_MIN);
+    const __m256i low = _mm256_set1_epi64x(static_cast<int64_t>(min));
+    const __m256i limit = _mm256_xor_si256(_mm256_set1_epi64x(static_cast<int64_t>(span)), sign);
+    uint64_t outside = 0;
+    for (uint32_t j = 0; j < numIntegers; j += 4)
+    {
+        const __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(values + j));
+        const __m256i above = _mm256_cmpgt_epi64(_mm256_xor_si256(_mm256_sub_epi64(v, low), sign), limit);
+        outside |= static_cast<uint64_t>(_mm256_movemask_pd(_mm256_castsi256_pd(above))) << j;
+    }
+    return ~outside & ((1ULL << numIntegers) - 1);
+}
+#endif
+
+#if defined(SIMPLE8B_NEON_SIMD)
+inline uint64_t MatchRangeNeon(const uint64_t *values, uint32_t numIntegers, uint64_t min, uint64_t span)
+{
+    const uint64x2_t low = vdupq_n_u64(min);
+    const uint64x2_t limit = vdupq_n_u64(span);
+    uint64_t mask = 0;
+    for (uint32_t j = 0; j < numIntegers; j += 2)
+    {
+        const uint64x2_t inside = vcleq_u64(vsubq_u64(vld1q_u64(values + j), low), limit);
+        mask |= ((vgetq_lane_u64(inside, 0) & 1) | (vgetq_lane_u64(inside, 1) & 2)) << j;
+    }
+    return mask & ((1ULL << numIntegers) - 1);
+}
+#endif
+
+#if defined(SIMPLE8B_WASM_SIMD)
+inline uint64_t MatchRangeWasm(const uint64_t *values, uint32_t numIntegers, uint64_t min, uint64_t span)
+{
+    // no unsigned 64-bit compare: flip the sign bits and use the signed one
+    const v128_t sign = wasm_u64x2_splat(1ULL << 63);
+    const v128_t low = wasm_u64x2_splat(min);
+    const v128_t limit = wasm_v128_xor(wasm_u64x2_splat(span), sign);
+    uint64_t mask = 0;
+    for (uint32_t j = 0; j < numIntegers; j += 2)
+    {
+        const v128_t offset = wasm_v128_xor(wasm_i64x2_sub(wasm_v128_load(values + j), low), sign);
+        mask |= static_cast<uint64_t>(wasm_i64x2_bitmask(wasm_i64x2_le(offset, limit))) << j;
+    }
+    return mask & ((1ULL << numIntegers) - 1);
+}
+#endif
+
+// sets the bits of matching values in a zeroed bitmap
+struct BitmapSink
+{
+    uint64_t *bitmap;
+
+    void Run(uint64_t position, uint64_t numIntegers)
+    {
+        for (; numIntegers > 0 && position % 64 != 0; numIntegers--, position++)
+            bitmap[position / 64] |= 1ULL << (position % 64);
+        for (; numIntegers >= 64; numIntegers -= 64, position += 64)
+            bitmap[position / 64] = ~0ULL;
+        if (numIntegers > 0)
+            bitmap[position / 64] |= (1ULL << numIntegers) - 1;
+    }
+
+    // ORs in the match mask of a word's values, which may straddle two bitmap words
+    void Mask(uint64_t position, uint64_t mask)
+    {
+        const uint64_t shift = position % 64;
+        bitmap[position / 64] |= mask << shift;
+        if (shift != 0 && (mask >> (64 - shift)) != 0)
+            bitmap[position / 64 + 1] |= mask >> (64 - shift);
+    }
+};
+
+// appends the positions of matching values
+struct PositionSink
+{
+    uint64_t *positions;
+
+    void Run(uint64_t position, uint64_t numIntegers)
+    {
+        for (uint64_t i = 0; i < numIntegers; i++)
+            *positions++ = position + i;
+    }
+
+    void Mask(uint64_t position, uint64_t mask)
+    {
+        for (; mask != 0; mask &= mask - 1)
+            *positions++ = position + GetTrailingZeros(mask);
+    }
+};
+
+// words of at most this many values are compared as they are extracted, without unpacking
+const uint32_t SIMPLE8B_FILTER_SCALAR_INTEGERS = 4;
+
+template <uint64_t (*matchRange)(const uint64_t *, uint32_t, uint64_t, uint64_t), typename Sink>
+inline uint64_t FilterWords(const uint64_t *input, uint64_t uncompressedLength, uint64_t min, uint64_t max,
+                            Sink &sink)
+{
+    // the vector kernels may read past a word's values: keep what they read initialized
+    uint64_t scratch[240];
+    std::fill(scratch, scratch + 64, 0);
+    uint64_t numMatches = 0;
+    for (uint64_t position = 0; position < uncompressedLength; input++)
+    {
+        const uint32_t selector = GetSelectorNum(input);
+        const uint32_t numIntegers = static_cast<uint32_t>(GetWordIntegers(input, position, uncompressedLength));
+        const uint64_t bound = SIMPLE8B_SELECTOR_MAX_VALUE[selector];
+        if (min == 0 && max >= bound)
+        {
+            sink.Run(position, numIntegers);
+            numMatches += numIntegers;
+        }
+        else if (min <= bound && numIntegers <= SIMPLE8B_FILTER_SCALAR_INTEGERS)
+        {
+            uint64_t mask = 0;
+            for (uint32_t k = 0; k < numIntegers; k++)
+                mask |= static_cast<uint64_t>(GetWordInteger(*input, selector, k) - min <= max - min) << k;
+            sink.Mask(position, mask);
+            numMatches += GetPopCount(mask);
+        }
+        else if (min <= bound)
+        {
+            uint64_t *tmp = scratch;
+            const uint64_t *word = input;
+            UnpackWord(tmp, word);
+            const uint64_t mask = matchRange(scratch, numIntegers, min, max - min);
+            sink.Mask(position, mask);
+            numMatches += GetPopCount(mask);
+        }
+        position += numIntegers;
+    }
+    return numMatches;
+}
+
+#if defined(SIMPLE8B_X86_SIMD)
+// flattened, so the compare kernel and the unpacking inline into a function compiled for AVX2
+template <typename Sink>
+SIMPLE8B_TARGET_AVX2 __attribute__((flatten)) inline uint64_t FilterWordsAvx2(const uint64_t *input,
+                                                                            uint64_t uncompressedLength,
+                                                                            uint64_t min, uint64_t max, Sink &sink)
+{
+    return FilterWords<MatchRangeAvx2>(input, uncompressedLength, min, max, sink);
+}
+#endif
+
+// runs the filter with the active compare kernel; selects nothing when min > max
+template <typename Sink>
+inline uint64_t FilterWordsSimd(const uint64_t *input, uint64_t uncompressedLength, uint64_t min, uint64_t max,
+                                Sink &sink)
+{
+    if (min > max)
+        return 0;
+    switch (ActiveSimdLevel())
+    {
+#if defined(SIMPLE8B_X86_SIMD)
+    case SIMPLE8B_SIMD_AVX512:
+    case SIMPLE8B_SIMD_AVX2:
+        return FilterWordsAvx2(input, uncompressedLength, min, max, sink);
+#elif defined(SIMPLE8B_NEON_SIMD)
+    case SIMPLE8B_SIMD_NEON:
+        return FilterWords<MatchRangeNeon>(input, uncompressedLength, min, max, sink);
+#elif defined(SIMPLE8B_WASM_SIMD)
+    case SIMPLE8B_SIMD_WASM128:
+        return FilterWords<MatchRangeWasm>(input, uncompressedLength, min, max, sink);
+#endif
+    default:
+        return FilterWords<MatchRange>(input, uncompressedLength, min, max, sink);
+    }
+}
+
+// selects the values in [min, max] into a bitmap
+SIMPLE8B_INLINE uint64_t Simple8bFilterRange(const uint64_t *input, uint64_t uncompressedLength, uint64_t min,
+                                             uint64_t max, uint64_t *bitmap)
+{
+    std::fill(bitmap, bitmap + (uncompressedLength + 63) / 64, 0);
+    BitmapSink sink = {bitmap};
+    return FilterWordsSimd(input, uncompressedLength, min, max, sink);
+}
+
+// selects the values above threshold into a bitmap
+SIMPLE8B_INLINE uint64_t Simple8bFilterGreater(const uint64_t *input, uint64_t uncompressedLength, uint64_t threshold,
+                                               uint64_t *bitmap)
+{
+    if (threshold == ~0ULL)
+        return Simple8bFilterRange(input, uncompressedLength, 1, 0, bitmap);
+    return Simple8bFilterRange(input, uncompressedLength, threshold + 1, ~0ULL, bitmap);
+}
+
+// selects the values below threshold into a bitmap
+SIMPLE8B_INLINE uint64_t Simple8bFilterLess(const uint64_t *input, uint64_t uncompressedLength, uint64_t threshold,
+                                            uint64_t *bitmap)
+{
+    if (threshold == 0)
+        return Simple8bFilterRange(input, uncompressedLength, 1, 0, bitmap);
+    return Simple8bFilterRange(input, uncompressedLength, 0, threshold - 1, bitmap);
+}
+
+// selects the values equal to value into a bitmap
+SIMPLE8B_INLINE uint64_t Simple8bFilterEqual(const uint64_t *input, uint64_t uncompressedLength, uint64_t value,
+                                             uint64_t *bitmap)
+{
+    return Simple8bFilterRange(input, uncompressedLength, value, value, bitmap);
+}
+
+// writes the positions of the values in [min, max] to positions, which needs room for as many
+// as there are matches (at most uncompressedLength)
+SIMPLE8B_INLINE uint64_t Simple8bFilterRangePositions(const uint64_t *input, uint64_t uncompressedLength,
+                                                      uint64_t min, uint64_t max, uint64_t *positions)
+{
+    PositionSink sink = {positions};
+    return FilterWordsSimd(input, uncompressedLength, min, max, sink);
+}
+
+/*
+    Simple8b-RLE: opt-in variant of the format for streams that sit at a constant non-zero value.
+
+    Selector 0 no longer means 240 zeros; its word is a run of the previous value (0 before the
+    first one), repeated as many times as the 60-bit payload says. Every other selector is
+    unchanged, so zero runs still start with a selector 1 word. The encoder emits a run word only
+    when the run is longer than one plain word of that value would hold, and the decoder expands
+    runs with vector stores. Streams are not interchangeable with Simple8bEncode ones.
+*/
+
+const uint64_t SIMPLE8B_RLE_MAX_RUN = (1ULL << 60) - 1;
+
+#if defined(SIMPLE8B_X86_SIMD)
+SIMPLE8B_TARGET_AVX2 inline void FillRunAvx2(uint64_t *out, uint64_t numIntegers, const uint64_t value)
+{
+    const __m256i values = _mm256_set1_epi64x(static_cast<long long>(value));
+    uint64_t i = 0;
+    for (; i + 4 <= numIntegers; i += 4)
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(out + i), values);
+    for (; i < numIntegers; i++)
+        out[i] = value;
+}
+#endif
+
+#if defined(SIMPLE8B_WASM_SIMD)
+inline void FillRunWasm(uint64_t *out, uint64_t numIntegers, const uint64_t value)
+{
+    const v128_t values = wasm_u64x2_splat(value);
+    uint64_t i = 0;
+    for (; i + 2 <= numIntegers; i += 2)
+        wasm_v128_store(out + i, values);
+    for (; i < numIntegers; i++)
+        out[i] = value;
+}
+#endif
+
+#if defined(SIMPLE8B_NEON_SIMD)
+inline void FillRunNeon(uint64_t *out, uint64_t numIntegers, const uint64_t value)
+{
+    const uint64x2_t values = vdupq_n_u64(value);
+    uint64_t i = 0;
+    for (; i + 2 <= numIntegers; i += 2)
+        vst1q_u64(out + i, values);
+    for (; i < numIntegers; i++)
+        out[i] = value;
+}
+#endif
+
+template <typename T>
+inline void FillRun(T *out, uint64_t numIntegers, const T value)
+{
+    if (sizeof(T) == sizeof(uint64_t))
+    {
+        uint64_t *out64 = reinterpret_cast<uint64_t *>(out);
+        const uint64_t value64 = static_cast<uint64_t>(value);
+#if defined(SIMPLE8B_X86_SIMD)
+        if (ActiveSimdLevel() >= SIMPLE8B_SIMD_AVX2)
+            return FillRunAvx2(out64, numIntegers, value64);
+#elif defined(SIMPLE8B_NEON_SIMD)
+        if (ActiveSimdLevel() >= SIMPLE8B_SIMD_NEON)
+            return FillRunNeon(out64, numIntegers, value64);
+#elif defined(SIMPLE8B_WASM_SIMD)
+        if (ActiveSimdLevel() == SIMPLE8B_SIMD_WASM128)
+            return FillRunWasm(out64, numIntegers, value64);
+#endif
+    }
+    std::fill(out, out + numIntegers, value);
+}
+
+template <typename T>
+uint64_t Simple8bRleEncode(const T *input, uint64_t inputLength, uint64_t *out)
+{
+    const uint64_t *const initout = out;
+    const T *in = input;
+    const T *const end = input + inputLength;
+    T previous = 0;
+
+    while (end > in)
+    {
+        const uint64_t maxRun = std::min<uint64_t>(static_cast<uint64_t>(end - in), SIMPLE8B_RLE_MAX_RUN);
+        uint64_t run = 0;
+        while (run < maxRun && in[run] == previous)
+            run++;
+        const uint32_t plainSelector = SIMPLE8B_WIDTH_SELECTOR[GetBitWidth(static_cast<uint64_t>(previous))];
+        if (run > SIMPLE8B_SELECTOR_INTEGERS[plainSelector])
+        {
+            *out++ = run;
+            in += run;
+            continue;
+        }
+
+        // selector 0 is taken by run words, so 240 zeros go out as 120 and the rest becomes a run
+        uint32_t selector = FindSelector(in, static_cast<uint64_t>(end - in));
+        if (selector == 0)
+            selector = 1;
+        if (IsTooLarge(selector, in))
+            return SIMPLE8B_ERROR_VALUE_TOO_LARGE;
+        const uint32_t numIntegers = std::min<uint32_t>(static_cast<uint32_t>(std::min<uint64_t>(end - in, 240)),
+                                                        SIMPLE8B_SELECTOR_INTEGERS[selector]);
+        PackWord(selector, numIntegers, out, in);
+        previous = in[-1];
+    }
+    return out - initout;
+}
+
+template <typename T>
+const uint64_t Simple8bRleDecode(uint64_t *input, uint64_t uncompressedLength, T *out)
+{
+    const uint64_t *in = input;
+    const T *const end = out + uncompressedLength;
+    const T *const initout = out;
+    T scratch[240];
+    T previous = 0;
+
+    while (end > out)
+    {
+        const uint64_t remaining = static_cast<uint64_t>(end - out);
+        if (GetSelectorNum(in) == 0)
+        {
+            const uint64_t numIntegers = std::min<uint64_t>(*in++, remaining);
+            FillRun(out, numIntegers, previous);
+            out += numIntegers;
+            continue;
+        }
+        if (remaining > 240)
+        {
+            UnpackWord(out, in);
+        }
+        else
+        {
+            T *tmp = scratch;
+            UnpackWord(tmp, in);
+            const uint64_t numIntegers = std::min<uint64_t>(static_cast<uint64_t>(tmp - scratch), remaining);
+            std::copy(scratch, scratch + numIntegers, out);
+            out += numIntegers;
+        }
+        previous = out[-1];
+    }
+    return out - initout;
+}
+
+/*
+    Escaped streams, for inputs that may hold values above SIMPLE8B_MAX_VALUE (nanosecond
+    timestamps, raw 64-bit counters, negative integers).
+
+    Layout: [numExceptions][numStreamWords][Simple8b stream][positions][values]. Each exception is
+    coded as 0 in the stream, and its position and full 64-bit value go in the side list. The input
+    is first encoded as is, so a stream without exceptions costs nothing over Simple8bEncode; only
+    when that fails is it re-encoded through a staging buffer. Output needs room for
+    SIMPLE8B_ESCAPED_HEADER_WORDS + 3 * inputLength words.
+*/
+
+const uint64_t SIMPLE8B_ESCAPED_HEADER_WORDS = 2;
+
+template <typename T>
+uint64_t Simple8bEncodeEscaped(const T *input, uint64_t inputLength, uint64_t *out)
+{
+    uint64_t *streamOut = out + SIMPLE8B_ESCAPED_HEADER_WORDS;
+    out[0] = 0;
+    {
+        const T *in = input;
+        if (EncodeFast(in, input + inputLength, streamOut) && EncodeCareful(in, input + inputLength, streamOut))
+        {
+            out[1] = static_cast<uint64_t>(streamOut - out) - SIMPLE8B_ESCAPED_HEADER_WORDS;
+            return static_cast<uint64_t>(streamOut - out);
+        }
+    }
+
+    // exceptions are rare: collect them at the far end of the output, past the longest stream,
+    // then move them down behind it. The input is staged with zeros in their place
+    uint64_t *const positions = out + SIMPLE8B_ESCAPED_HEADER_WORDS + inputLength;
+    uint64_t *const values = positions + inputLength;
+    uint64_t numExceptions = 0;
+    T staged[SIMPLE8B_FUSED_BLOCK + 240];
+    uint64_t numStaged = 0;
+    streamOut = out + SIMPLE8B_ESCAPED_HEADER_WORDS;
+    for (uint64_t done = 0; done < inputLength;)
+    {
+        const uint64_t blockLength = std::min<uint64_t>(inputLength - done, SIMPLE8B_FUSED_BLOCK);
+        for (uint64_t i = 0; i < blockLength; i++)
+        {
+            const uint64_t v = static_cast<uint64_t>(input[done + i]);
+            if (v > SIMPLE8B_MAX_VALUE)
+            {
+                positions[numExceptions] = done + i;
+                values[numExceptions++] = v;
+            }
+            staged[numStaged + i] = (v > SIMPLE8B_MAX_VALUE) ? 0 : input[done + i];
+        }
+        done += blockLength;
+        numStaged += blockLength;
+
+        const T *in = staged;
+        EncodeFast(in, staged + numStaged, streamOut);
+        numStaged = static_cast<uint64_t>(staged + numStaged - in);
+        std::copy(in, in + numStaged, staged);
+    }
+    const T *in = staged;
+    EncodeCareful(in, staged + numStaged, streamOut);
+
+    out[0] = numExceptions;
+    out[1] = static_cast<uint64_t>(streamOut - out) - SIMPLE8B_ESCAPED_HEADER_WORDS;
+    // both moves go down (or nowhere), so copying forward never overwrites what is left to read
+    for (uint64_t i = 0; i < numExceptions; i++)
+        streamOut[i] = positions[i];
+    streamOut += numExceptions;
+    for (uint64_t i = 0; i < numExceptions; i++)
+        streamOut[i] = values[i];
+    streamOut += numExceptions;
+    return static_cast<uint64_t>(streamOut - out);
+}
+
+template <typename T>
+const uint64_t Simple8bDecodeEscaped(uint64_t *input, uint64_t uncompressedLength, T *out)
+{
+    const uint64_t numExceptions = input[0];
+    uint64_t *const stream = input + SIMPLE8B_ESCAPED_HEADER_WORDS;
+    const uint64_t *const positions = stream + input[1];
+    const uint64_t *const values = positions + numExceptions;
+
+    const uint64_t numDecoded = Simple8bDecode(stream, uncompressedLength, out);
+    for (uint64_t i = 0; i < numExceptions; i++)
+        out[positions[i]] = static_cast<T>(values[i]);
+    return numDecoded;
+}
+
+/*
+    Output bounds and capacity-checked entry points.
+
+    Every word codes at least one value, so a stream never has more words than values, and as long
+    as the room left covers the values left nothing needs checking. Below that, the fast loops run
+    on a segment no longer than the room left (words only ever look 240 values ahead, so the
+    segment does not change the stream) and the last words are checked one at a time.
+*/
+
+// worst-case number of words Simple8bEncode writes for inputLength values (all sizes here are in
+// uint64_t words); reached when every value needs more than 30 bits
+SIMPLE8B_INLINE uint64_t Simple8bMaxCompressedSize(uint64_t inputLength)
+{
+    return inputLength;
+}
+
+// worst case when no value is wider than maxBitWidth bits (0-60): every word but the last holds
+// at least as many values as the densest selector for that width
+SIMPLE8B_INLINE uint64_t Simple8bMaxCompressedSizeForWidth(uint64_t inputLength, uint32_t maxBitWidth)
+{
+    const uint64_t numIntegers = SIMPLE8B_SELECTOR_INTEGERS[SIMPLE8B_WIDTH_SELECTOR[maxBitWidth]];
+    return (inputLength + numIntegers - 1) / numIntegers;
+}
+
+// Simple8bEncode writing at most outCapacity words; returns the number of words written,
+// SIMPLE8B_ERROR_OUTPUT_TOO_SMALL or SIMPLE8B_ERROR_VALUE_TOO_LARGE
+template <typename T>
+uint64_t Simple8bEncodeChecked(const T *input, uint64_t inputLength, uint64_t *out, uint64_t outCapacity)
+{
+    const uint64_t *const initout = out;
+    const T *in = input;
+    const T *const end = input + inputLength;
+
+    while (end > in)
+    {
+        const uint64_t room = outCapacity - static_cast<uint64_t>(out - initout);
+        if (room >= static_cast<uint64_t>(end - in))
+        {
+            if (!EncodeFast(in, end, out) || !EncodeCareful(in, end, out))
+                return SIMPLE8B_ERROR_VALUE_TOO_LARGE;
+            break;
+        }
+
+        const T *const before = in;
+        if (!EncodeFast(in, in + room, out))
+            return SIMPLE8B_ERROR_VALUE_TOO_LARGE;
+        if (in != before)
+            continue;
+
+        // fewer than 240 values of room: one word at a time
+        if (room == 0)
+            return SIMPLE8B_ERROR_OUTPUT_TOO_SMALL;
+        const uint32_t selector = FindSelector(in, static_cast<uint64_t>(end - in));
+        if (IsTooLarge(selector, in))
+            return SIMPLE8B_ERROR_VALUE_TOO_LARGE;
+        PackWord(selector, std::min<uint32_t>(static_cast<uint32_t>(std::min<uint64_t>(end - in, 240)),
+                                              SIMPLE8B_SELECTOR_INTEGERS[selector]),
+                 out, in);
+    }
+    return out - initout;
+}
+
+// Simple8bDecode reading at most inputWords words; returns uncompressedLength, or
+// SIMPLE8B_ERROR_INPUT_TRUNCATED if the input runs out first (the values decoded so far are written)
+template <typename T>
+const uint64_t Simple8bDecodeChecked(const uint64_t *input, uint64_t inputWords, uint64_t uncompressedLength, T *out)
+{
+    const uint64_t *in = input;
+    const uint64_t *const inEnd = input + inputWords;
+    const T *const end = out + uncompressedLength;
+    const T *const initout = out;
+    T scratch[240];
+
+    while (end > out)
+    {
+        const uint64_t wordsLeft = static_cast<uint64_t>(inEnd - in);
+        if (wordsLeft >= static_cast<uint64_t>(end - out))
+        {
+            DecodeFast(in, out, end);
+            DecodeCareful(in, out, end);
+            break;
+        }
+
+        T *const before = out;
+        DecodeFast(in, out, out + wordsLeft);
+        if (out != before)
+            continue;
+
+        if (wordsLeft == 0)
+            return SIMPLE8B_ERROR_INPUT_TRUNCATED;
+        T *tmp = scratch;
+        UnpackWord(tmp, in);
+        const uint64_t numIntegers = std::min<uint64_t>(static_cast<uint64_t>(tmp - scratch),
+                                                        static_cast<uint64_t>(end - out));
+        std::copy(scratch, scratch + numIntegers, out);
+        out += numIntegers;
+    }
+    return out - initout;
+}
+
+/*
+    Adaptive per-block codec: every block of SIMPLE8B_ADAPTIVE_BLOCK values is stored with
+    whichever of three codecs is smallest for it.
+
+        - Simple8b, for skewed blocks where most values are much narrower than the widest
+        - bit-packing at the block's maximum width, for high-entropy blocks, where Simple8b's
+          selectors and coarse widths (nothing between 8, 10, 12, 15 and 20 bits) waste space
+        - raw 64-bit words, for blocks of values wider than 60 bits, which Simple8b cannot hold
+
+    A block is one header word followed by its payload words. The header holds the codec tag
+    in its low byte, the packed width in the next byte and the number of payload words in the
+    upper 32 bits. Values are coded as the unsigned type of T, so signed inputs need no zigzag
+    unless they are usually small and negative.
+
+    The encoder builds a bit-width histogram per block: the maximum width gives the exact packed
+    size, and the width counts give an (optimistic) Simple8b estimate. Simple8b is only tried
+    when the estimate beats the other two, and is kept only if its real size still does.
+
+    Packed blocks are made of groups of SIMPLE8B_PACKED_GROUP values in 2 * numBits words, with
+    even and odd values in two interleaved lanes of words (value 2k + l is bits
+    [k * numBits, (k + 1) * numBits) of lane l). Each step of the decoder then extracts the
+    same bits from a pair of adjacent words, which maps onto 128-bit vectors directly and onto
+    256-bit ones two groups at a time. A final short group is padded with zeros.
+*/
+
+const uint64_t SIMPLE8B_ADAPTIVE_BLOCK = 1024;
+const uint32_t SIMPLE8B_PACKED_GROUP = 128;
+
+const uint8_t SIMPLE8B_BLOCK_SIMPLE8B = 0;
+const uint8_t SIMPLE8B_BLOCK_PACKED = 1;
+const uint8_t SIMPLE8B_BLOCK_RAW = 2;
+
+// payload words of numIntegers values packed at numBits bits
+inline uint64_t GetPackedWords(uint64_t numIntegers, uint32_t numBits)
+{
+    return (numIntegers + SIMPLE8B_PACKED_GROUP - 1) / SIMPLE8B_PACKED_GROUP * 2 * numBits;
+}
+
+// low numBits bits set, for 0-64 bits
+inline uint64_t GetPackedMask(uint32_t numBits)
+{
+    return (numBits == 64) ? ~0ULL : (1ULL << numBits) - 1;
+}
+
+// lower bound on the Simple8b words of a block from its bit-width histogram: every value pays its
+// share of a word of its own width, ie as if no word mixed widths
+inline uint64_t EstimateSimple8bWords(const uint32_t *histogram)
+{
+    uint64_t cost = 0; // in 1/2^16 words
+    for (uint32_t numBits = 0; numBits <= 60; numBits++)
+        cost += (static_cast<uint64_t>(histogram[numBits]) << 16) /
+                SIMPLE8B_SELECTOR_INTEGERS[SIMPLE8B_WIDTH_SELECTOR[numBits]];
+    return (cost + 0xFFFF) >> 16;
+}
+
+// packs up to one group of values (the rest of the group is zero) into 2 * numBits words
+template <typename U>
+inline void PackGroup(const U *in, uint64_t numIntegers, uint32_t numBits, uint64_t *out)
+{
+    std::fill(out, out + 2 * numBits, 0);
+    for (uint32_t i = 0; i < numIntegers; i++)
+    {
+        const uint64_t value = static_cast<uint64_t>(in[i]);
+        const uint32_t lane = i & 1;
+        const uint32_t bit = (i >> 1) * numBits;
+        const uint32_t shift = bit % 64;
+        out[2 * (bit / 64) + lane] |= value << shift;
+        if (shift + numBits > 64)
+            out[2 * (bit / 64 + 1) + lane] |= value >> (64 - shift);
+    }
+}
+
+// unpacks one whole group; reference implementation and fallback for the vector kernels
+template <uint32_t numBits, typename T>
+inline void UnpackGroup(const uint64_t *in, T *out)
+{
+    const uint64_t mask = GetPackedMask(numBits);
+    for (uint32_t k = 0; k < SIMPLE8B_PACKED_GROUP / 2; k++)
+    {
+        const uint32_t bit = k * numBits;
+        const uint32_t shift = bit % 64;
+        for (uint32_t lane = 0; lane < 2; lane++)
+        {
+            uint64_t value = in[2 * (bit / 64) + lane] >> shift;
+            // shift > 0 whenever the value straddles two words; the mask only quiets the
+            // warning for the straddle-free unrolled iterations
+            if (shift + numBits > 64)
+                value |= in[2 * (bit / 64 + 1) + lane] << ((64 - shift) & 63);
+            out[2 * k + lane] = static_cast<T>(value & mask);
+        }
+    }
+}
+
+#if defined(SIMPLE8B_X86_SIMD)
+// two groups per iteration, the pair of words of the first group in the low half of each vector
+// and the second group's in the high half
+template <uint32_t numBits>
+SIMPLE8B_TARGET_AVX2 inline uint64_t UnpackGroupsAvx2(const uint64_t *in, uint64_t numGroups, uint64_t *out)
+{
+    const __m256i mask = _mm256_set1_epi64x(static_cast<long long>(GetPackedMask(numBits)));
+    uint64_t g = 0;
+    for (; g + 2 <= numGroups; g += 2)
+    {
+        const uint64_t *first = in + 2 * numBits * g;
+        const uint64_t *second = first + 2 * numBits;
+        uint64_t *firstOut = out + SIMPLE8B_PACKED_GROUP * g;
+        // unrolled in full, so every shift and word offset is a constant
+#pragma GCC unroll 64
+        for (uint32_t k = 0; k < SIMPLE8B_PACKED_GROUP / 2; k++)
+        {
+            const uint32_t bit = k * numBits;
+            const uint32_t shift = bit % 64;
+            const uint32_t word = 2 * (bit / 64);
+            __m256i values = _mm256_inserti128_si256(
+                _mm256_castsi128_si256(_mm_loadu_si128(reinterpret_cast<const __m128i *>(first + word))),
+                _mm_loadu_si128(reinterpret_cast<const __m128i *>(second + word)), 1);
+            values = _mm256_srli_epi64(values, static_cast<int>(shift));
+            if (shift + numBits > 64)
+            {
+                const __m256i next = _mm256_inserti128_si256(
+                    _mm256_castsi128_si256(_mm_loadu_si128(reinterpret_cast<const __m128i *>(first + word + 2))),
+                    _mm_loadu_si128(reinterpret_cast<const __m128i *>(second + word + 2)), 1);
+                values = _mm256_or_si256(values, _mm256_slli_epi64(next, static_cast<int>(64 - shift)));
+            }
+            values = _mm256_and_si256(values, mask);
+            _mm_storeu_si128(reinterpret_cast<__m128i *>(firstOut + 2 * k), _mm256_castsi256_si128(values));
+            _mm_storeu_si128(reinterpret_cast<__m128i *>(firstOut + SIMPLE8B_PACKED_GROUP + 2 * k),
+                             _mm256_extracti128_si256(values, 1));
+        }
+    }
+    return g;
+}
+#endif
+
+#if defined(SIMPLE8B_NEON_SIMD)
+template <uint32_t numBits>
+inline uint64_t UnpackGroupsNeon(const uint64_t *in, uint64_t numGroups, uint64_t *out)
+{
+    const uint64x2_t mask = vdupq_n_u64(GetPackedMask(numBits));
+    for (uint64_t g = 0; g < numGroups; g++)
+    {
+        const uint64_t *group = in + 2 * numBits * g;
+        uint64_t *groupOut = out + SIMPLE8B_PACKED_GROUP * g;
+#pragma GCC unroll 64
+        for (uint32_t k = 0; k < SIMPLE8B_PACKED_GROUP / 2; k++)
+        {
+            const uint32_t bit = k * numBits;
+            const uint32_t shift = bit % 64;
+            const uint32_t word = 2 * (bit / 64);
+            // vshlq_u64 shifts right for negative shift counts
+            uint64x2_t values = vshlq_u64(vld1q_u64(group + word), vdupq_n_s64(-static_cast<int64_t>(shift)));
+            if (shift + numBits > 64)
+                values = vorrq_u64(values, vshlq_u64(vld1q_u64(group + word + 2), vdupq_n_s64(64 - shift)));
+            vst1q_u64(groupOut + 2 * k, vandq_u64(values, mask));
+        }
+    }
+    return numGroups;
+}
+#endif
+
+#if defined(SIMPLE8B_WASM_SIMD)
+template <uint32_t numBits>
+inline uint64_t UnpackGroupsWasm(const uint64_t *in, uint64_t numGroups, uint64_t *out)
+{
+    const v128_t mask = wasm_u64x2_splat(GetPackedMask(numBits));
+    for (uint64_t g = 0; g < numGroups; g++)
+    {
+        const uint64_t *group = in + 2 * numBits * g;
+        uint64_t *groupOut = out + SIMPLE8B_PACKED_GROUP * g;
+#pragma GCC unroll 64
+        for (uint32_t k = 0; k < SIMPLE8B_PACKED_GROUP / 2; k++)
+        {
+            const uint32_t bit = k * numBits;
+            const uint32_t shift = bit % 64;
+            const uint32_t word = 2 * (bit / 64);
+            v128_t values = wasm_u64x2_shr(wasm_v128_load(group + word), shift);
+            if (shift + numBits > 64)
+                values = wasm_v128_or(values, wasm_i64x2_shl(wasm_v128_load(group + word + 2), 64 - shift));
+            wasm_v128_store(groupOut + 2 * k, wasm_v128_and(values, mask));
+        }
+    }
+    return numGroups;
+}
+#endif
+
+// unpacks numIntegers values of a packed block, whole groups with the vector kernels when the
+// output is 64-bit
+template <uint32_t numBits, typename T>
+inline void UnpackPacked(const uint64_t *in, uint64_t numIntegers, T *out)
+{
+    // all-zero blocks have no payload words to read
+    if (numBits == 0)
+        return std::fill(out, out + numIntegers, static_cast<T>(0));
+
+    const uint64_t numGroups = numIntegers / SIMPLE8B_PACKED_GROUP;
+    uint64_t g = 0;
+    if (sizeof(T) == sizeof(uint64_t))
+    {
+        uint64_t *out64 = reinterpret_cast<uint64_t *>(out);
+#if defined(SIMPLE8B_X86_SIMD)
+        if (ActiveSimdLevel() >= SIMPLE8B_SIMD_AVX2)
+            g = UnpackGroupsAvx2<numBits>(in, numGroups, out64);
+#elif defined(SIMPLE8B_NEON_SIMD)
+        if (ActiveSimdLevel() >= SIMPLE8B_SIMD_NEON)
+            g = UnpackGroupsNeon<numBits>(in, numGroups, out64);
+#elif defined(SIMPLE8B_WASM_SIMD)
+        if (ActiveSimdLevel() == SIMPLE8B_SIMD_WASM128)
+            g = UnpackGroupsWasm<numBits>(in, numGroups, out64);
+#endif
+        (void)out64;
+    }
+    for (; g < numGroups; g++)
+        UnpackGroup<numBits>(in + 2 * numBits * g, out + SIMPLE8B_PACKED_GROUP * g);
+
+    const uint64_t numLeft = numIntegers - numGroups * SIMPLE8B_PACKED_GROUP;
+    if (numLeft > 0)
+    {
+        T scratch[SIMPLE8B_PACKED_GROUP];
+        UnpackGroup<numBits>(in + 2 * numBits * numGroups, scratch);
+        std::copy(scratch, scratch + numLeft, out + numGroups * SIMPLE8B_PACKED_GROUP);
+    }
+}
+
+template <typename T>
+using Simple8bUnpackPackedFunction = void (*)(const uint64_t *, uint64_t, T *);
+
+// UnpackPacked for every width 0-64, indexed by the width in the block header
+template <typename T, size_t... widths>
+constexpr std::array<Simple8bUnpackPackedFunction<T>, 65> MakeUnpackPackedTable(std::index_sequence<widths...>)
+{
+    return {{&UnpackPacked<static_cast<uint32_t>(widths), T>...}};
+}
+
+template <typename T>
+inline void UnpackPackedBlock(const uint64_t *in, uint64_t numIntegers, uint32_t numBits, T *out)
+{
+    static constexpr std::array<Simple8bUnpackPackedFunction<T>, 65> table =
+        MakeUnpackPackedTable<T>(std::make_index_sequence<65>());
+    table[numBits](in, numIntegers, out);
+}
+
+// worst-case words of Simple8bAdaptiveEncode: one header per block, and no block is larger than raw
+SIMPLE8B_INLINE uint64_t Simple8bAdaptiveMaxCompressedSize(uint64_t inputLength)
+{
+    return inputLength + (inputLength + SIMPLE8B_ADAPTIVE_BLOCK - 1) / SIMPLE8B_ADAPTIVE_BLOCK;
+}
+
+// returns the number of words written; every value of T is representable, so it never fails
+template <typename T>
+uint64_t Simple8bAdaptiveEncode(const T *input, uint64_t inputLength, uint64_t *out)
+{
+    typedef typename std::make_unsigned<T>::type U;
+    const uint64_t *const initout = out;
+
+    for (uint64_t done = 0; done < inputLength;)
+    {
+        const uint64_t blockLength = std::min<uint64_t>(inputLength - done, SIMPLE8B_ADAPTIVE_BLOCK);
+        const U *block = reinterpret_cast<const U *>(input + done);
+        uint32_t histogram[65] = {0};
+        for (uint64_t i = 0; i < blockLength; i++)
+            histogram[GetBitWidth(block[i])]++;
+        uint32_t maxBits = 64;
+        while (maxBits > 0 && histogram[maxBits] == 0)
+            maxBits--;
+
+        uint64_t *header = out++;
+        const uint64_t packedWords = GetPackedWords(blockLength, maxBits);
+        uint64_t numWords = std::min(packedWords, blockLength);
+        uint8_t codec = (packedWords < blockLength) ? SIMPLE8B_BLOCK_PACKED : SIMPLE8B_BLOCK_RAW;
+
+        if (maxBits <= 60 && EstimateSimple8bWords(histogram) < numWords)
+        {
+            const U *in = block;
+            uint64_t *words = out;
+            EncodeFast(in, block + blockLength, words);
+            EncodeCareful(in, block + blockLength, words);
+            if (static_cast<uint64_t>(words - out) < numWords)
+            {
+                codec = SIMPLE8B_BLOCK_SIMPLE8B;
+                numWords = static_cast<uint64_t>(words - out);
+            }
+        }
+
+        if (codec == SIMPLE8B_BLOCK_PACKED)
+        {
+            for (uint64_t i = 0; i < blockLength; i += SIMPLE8B_PACKED_GROUP)
+                PackGroup(block + i, std::min<uint64_t>(blockLength - i, SIMPLE8B_PACKED_GROUP), maxBits,
+                          out + 2 * maxBits * (i / SIMPLE8B_PACKED_GROUP));
+        }
+        else if (codec == SIMPLE8B_BLOCK_RAW)
+        {
+            for (uint64_t i = 0; i < blockLength; i++)
+                out[i] = block[i];
+        }
+
+        *header = codec | (static_cast<uint64_t>(maxBits) << 8) | (numWords << 32);
+        out += numWords;
+        done += blockLength;
+    }
+
+    return out - initout;
+}
+
+template <typename T>
+const uint64_t Simple8bAdaptiveDecode(uint64_t *input, uint64_t uncompressedLength, T *out)
+{
+    typedef typename std::make_unsigned<T>::type U;
+    const uint64_t *in = input;
+
+    for (uint64_t done = 0; done < uncompressedLength;)
+    {
+        const uint64_t blockLength = std::min<uint64_t>(uncompressedLength - done, SIMPLE8B_ADAPTIVE_BLOCK);
+        const uint64_t header = *in++;
+        const uint64_t numWords = header >> 32;
+        U *blockOut = reinterpret_cast<U *>(out + done);
+
+        switch (header & 0xFF)
+        {
+        case SIMPLE8B_BLOCK_SIMPLE8B:
+        {
+            const uint64_t *words = in;
+            const U *const blockEnd = blockOut + blockLength;
+            DecodeFast(words, blockOut, blockEnd);
+            DecodeCareful(words, blockOut, blockEnd);
+            break;
+        }
+        case SIMPLE8B_BLOCK_PACKED:
+            UnpackPackedBlock(in, blockLength, static_cast<uint32_t>((header >> 8) & 0xFF), blockOut);
+            break;
+        default:
+            for (uint64_t i = 0; i < blockLength; i++)
+                blockOut[i] = static_cast<U>(in[i]);
+            break;
+        }
+
+        in += numWords;
+        done += blockLength;
+    }
+
+    return uncompressedLength;
+}
+
+/*
+    Fixed-length pages, for callers that compress their data in pages of a compile-time size
+    (eg 1024 values). The page length is a template argument, so every page size gets its own
+    copy of the encode and decode loops with their bounds folded to constants, and the output
+    bound is a constant expression usable as an array size:
+
+        uint64_t words[Simple8bPageMaxWords(1024, 12)];
+        const uint64_t numWords = Simple8bEncodePage<1024>(values, words);
+        Simple8bDecodePage<1024>(words, values);
+*/
+
+// worst-case number of words for pageLength values no wider than maxBitWidth bits (see
+// Simple8bMaxCompressedSizeForWidth)
+constexpr uint64_t Simple8bPageMaxWords(uint64_t pageLength, uint32_t maxBitWidth = 64)
+{
+    return (pageLength + SIMPLE8B_SELECTOR_INTEGERS[SIMPLE8B_WIDTH_SELECTOR[maxBitWidth]] - 1) /
+           SIMPLE8B_SELECTOR_INTEGERS[SIMPLE8B_WIDTH_SELECTOR[maxBitWidth]];
+}
+
+// Simple8bEncode of exactly pageLength values
+template <uint64_t pageLength, typename T>
+inline uint64_t Simple8bEncodePage(const T *input, uint64_t *out)
+{
+    const uint64_t *const initout = out;
+    const T *in = input;
+    const T *const end = input + pageLength;
+
+    if (!EncodeFast(in, end, out) || !EncodeCareful(in, end, out))
+        return SIMPLE8B_ERROR_VALUE_TOO_LARGE;
+
+    return out - initout;
+}
+
+// Simple8bDecode of exactly pageLength values; returns pageLength
+template <uint64_t pageLength, typename T>
+inline uint64_t Simple8bDecodePage(const uint64_t *input, T *out)
+{
+    const uint64_t *in = input;
+    const T *const end = out + pageLength;
+
+    DecodeFast(in, out, end);
+    DecodeCareful(in, out, end);
+
+    return pageLength;
+}
+
+/*
+    On-disk container, for series persisted to files and read back through mmap.
+
+    Layout, in 64-bit words (host byte order, like the streams themselves):
+        [0]                     SIMPLE8B_FILE_MAGIC
+        [1]                     total number of values
+        [2]                     number of blocks
+        [3]                     values per block (the last block may hold fewer)
+        [4 + 5i] .. [8 + 5i]    block i: word offset of its Simple8b stream from the start of
+                                the file, number of values, min, max and first value
+        ...                     the block streams, back to back
+
+    Every field is a whole word, so the streams stay 8-byte aligned wherever the file is mapped
+    and decode straight from the mapping. Blocks are independent streams: a reader can decode
+    any one of them alone, and skip those whose min/max rule out a predicate without touching
+    their words. Min and max compare values as uint64_t, the only values Simple8b can store.
+*/
+
+const uint64_t SIMPLE8B_FILE_MAGIC = 0x31454C4946423853ULL; // "S8BFILE1"
+const uint64_t SIMPLE8B_FILE_HEADER_WORDS = 4;
+const uint64_t SIMPLE8B_FILE_BLOCK_WORDS = 5;
+
+struct Simple8bFileBlock
+{
+    uint64_t offset;    // word offset of the block's stream from the start of the file
+    uint64_t numValues; // values in the block
+    uint64_t min;
+    uint64_t max;
+    uint64_t first;
+};
+
+// size, in words, of the buffer Simple8bFileEncode needs
+inline uint64_t Simple8bFileMaxWords(uint64_t inputLength, uint64_t blockLength)
+{
+    const uint64_t numBlocks = (inputLength + blockLength - 1) / blockLength;
+    return SIMPLE8B_FILE_HEADER_WORDS + SIMPLE8B_FILE_BLOCK_WORDS * numBlocks + inputLength;
+}
+
+// writes the whole file image for inputLength values in blocks of blockLength (> 0) to out;
+// returns its size in words, or SIMPLE8B_ERROR_VALUE_TOO_LARGE
+template <typename T>
+uint64_t Simple8bFileEncode(const T *input, uint64_t inputLength, uint64_t blockLength, uint64_t *out)
+{
+    const uint64_t numBlocks = (inputLength + blockLength - 1) / blockLength;
+    uint64_t *const directory = out + SIMPLE8B_FILE_HEADER_WORDS;
+    out[0] = SIMPLE8B_FILE_MAGIC;
+    out[1] = inputLength;
+    out[2] = numBlocks;
+    out[3] = blockLength;
+
+    uint64_t *streamOut = directory + SIMPLE8B_FILE_BLOCK_WORDS * numBlocks;
+    for (uint64_t i = 0; i < numBlocks; i++)
+    {
+        const T *in = input + i * blockLength;
+        const T *const end = std::min(in + blockLength, input + inputLength);
+        uint64_t min = ~0ULL;
+        uint64_t max = 0;
+        for (const T *v = in; v < end; v++)
+        {
+            min = std::min<uint64_t>(min, static_cast<uint64_t>(*v));
+            max = std::max<uint64_t>(max, static_cast<uint64_t>(*v));
+        }
+
+        uint64_t *const entry = directory + SIMPLE8B_FILE_BLOCK_WORDS * i;
+        entry[0] = static_cast<uint64_t>(streamOut - out);
+        entry[1] = static_cast<uint64_t>(end - in);
+        entry[2] = min;
+        entry[3] = max;
+        entry[4] = static_cast<uint64_t>(*in);
+        if (!EncodeFast(in, end, streamOut) || !EncodeCareful(in, end, streamOut))
+            return SIMPLE8B_ERROR_VALUE_TOO_LARGE;
+    }
+
+    return static_cast<uint64_t>(streamOut - out);
+}
+
+// checks the header and directory at the start of a container image of fileWords words, which
+// must hold at least the header: streams follow the directory in order and end within the file,
+// every block but the last is full, and the block lengths add up to the total
+inline bool CheckFileDirectory(const uint64_t *head, uint64_t fileWords)
+{
+    if (head[0] != SIMPLE8B_FILE_MAGIC ||
+        head[2] > (fileWords - SIMPLE8B_FILE_HEADER_WORDS) / SIMPLE8B_FILE_BLOCK_WORDS)
+        return false;
+
+    const uint64_t numBlocks = head[2];
+    uint64_t offset = SIMPLE8B_FILE_HEADER_WORDS + SIMPLE8B_FILE_BLOCK_WORDS * numBlocks;
+    uint64_t numValues = 0;
+    for (uint64_t i = 0; i < numBlocks; i++)
+    {
+        const uint64_t *const entry = head + SIMPLE8B_FILE_HEADER_WORDS + SIMPLE8B_FILE_BLOCK_WORDS * i;
+        if (entry[0] < offset || entry[0] > fileWords || entry[1] > head[3] ||
+            (i + 1 < numBlocks && entry[1] != head[3]))
+            return false;
+        offset = entry[0];
+        numValues += entry[1];
+    }
+    return numValues == head[1];
+}
+
+/*
+    Read-only view of a Simple8bFileEncode image: either a file mapped with Open, or words
+    already in memory with Attach. Both check the header and directory, so a damaged file fails
+    to open instead of sending the decoder out of bounds; block decodes are capacity-checked
+    against the block's own words.
+*/
+
+class Simple8bFileReader
+{
+public:
+    Simple8bFileReader() : words(NULL), numWords(0), mapping(NULL), mappingBytes(0) {}
+
+    Simple8bFileReader(const Simple8bFileReader &) = delete;
+    Simple8bFileReader &operator=(const Simple8bFileReader &) = delete;
+
+    ~Simple8bFileReader()
+    {
+        Close();
+    }
+
+#if defined(SIMPLE8B_MMAP)
+    // maps the file read-only; returns false if it cannot be mapped or is not a valid container
+    bool Open(const char *path)
+    {
+        Close();
+        const int fd = open(path, O_RDONLY);
+        if (fd < 0)
+            return false;
+        struct stat info;
+        void *mapped = MAP_FAILED;
+        if (fstat(fd, &info) == 0 && info.st_size > 0)
+            mapped = mmap(NULL, static_cast<size_t>(info.st_size), PROT_READ, MAP_SHARED, fd, 0);
+        close(fd); // the mapping keeps the file open
+        if (mapped == MAP_FAILED)
+            return false;
+
+        mapping = mapped;
+        mappingBytes = static_cast<size_t>(info.st_size);
+        if (!Attach(static_cast<const uint64_t *>(mapped), mappingBytes / sizeof(uint64_t)))
+        {
+            Close();
+            return false;
+        }
+        return true;
+    }
+#endif
+
+    // reads a container from memory, which must stay valid (and 8-byte aligned) for as long as
+    // the reader uses it; returns false if it is not a valid container
+    bool Attach(const uint64_t *input, uint64_t inputWords)
+    {
+        words = NULL;
+        numWords = 0;
+        if (inputWords < SIMPLE8B_FILE_HEADER_WORDS || !CheckFileDirectory(input, inputWords))
+            return false;
+
+        words = input;
+        numWords = inputWords;
+        return true;
+    }
+
+    void Close()
+    {
+#if defined(SIMPLE8B_MMAP)
+        if (mapping != NULL)
+            munmap(mapping, mappingBytes);
+#endif
+        mapping = NULL;
+        mappingBytes = 0;
+        words = NULL;
+        numWords = 0;
+    }
+
+    bool IsOpen() const
+    {
+        return words != NULL;
+    }
+
+    // total number of values
+    uint64_t Length() const
+    {
+        return words[1];
+    }
+
+    uint64_t NumBlocks() const
+    {
+        return words[2];
+    }
+
+    Simple8bFileBlock Block(uint64_t i) const
+    {
+        const uint64_t *const entry = words + SIMPLE8B_FILE_HEADER_WORDS + SIMPLE8B_FILE_BLOCK_WORDS * i;
+        return {entry[0], entry[1], entry[2], entry[3], entry[4]};
+    }
+
+    // position of the first value of block i
+    uint64_t BlockStart(uint64_t i) const
+    {
+        return i * words[3];
+    }
+
+    // decodes block i into out, which needs room for its numValues values; returns that count,
+    // or SIMPLE8B_ERROR_INPUT_TRUNCATED if the block's stream ends early
+    template <typename T>
+    uint64_t DecodeBlock(uint64_t i, T *out) const
+    {
+        const uint64_t *const entry = words + SIMPLE8B_FILE_HEADER_WORDS + SIMPLE8B_FILE_BLOCK_WORDS * i;
+        const uint64_t end = (i + 1 < NumBlocks()) ? entry[SIMPLE8B_FILE_BLOCK_WORDS] : numWords;
+        return Simple8bDecodeChecked(words + entry[0], end - entry[0], entry[1], out);
+    }
+
+    // decodes every value into out; returns Length(), or SIMPLE8B_ERROR_INPUT_TRUNCATED
+    template <typename T>
+    uint64_t Decode(T *out) const
+    {
+        for (uint64_t i = 0; i < NumBlocks(); i++)
+        {
+            if (DecodeBlock(i, out + BlockStart(i)) == SIMPLE8B_ERROR_INPUT_TRUNCATED)
+                return SIMPLE8B_ERROR_INPUT_TRUNCATED;
+        }
+        return Length();
+    }
+
+    // writes the values in [min, max], in order, to values and their positions to positions
+    // (both need room for Length() entries); returns how many matched, or
+    // SIMPLE8B_ERROR_INPUT_TRUNCATED. Blocks whose range misses [min, max] are skipped unread
+    template <typename T>
+    uint64_t Select(uint64_t min, uint64_t max, T *values, uint64_t *positions) const
+    {
+        uint64_t numMatches = 0;
+        for (uint64_t i = 0; i < NumBlocks(); i++)
+        {
+            const Simple8bFileBlock block = Block(i);
+            if (block.max < min || block.min > max)
+                continue;
+
+            // decode behind the matches so far, then keep the matching values
+            T *const decoded = values + numMatches;
+            if (DecodeBlock(i, decoded) == SIMPLE8B_ERROR_INPUT_TRUNCATED)
+                return SIMPLE8B_ERROR_INPUT_TRUNCATED;
+            const uint64_t start = BlockStart(i);
+            const bool allMatch = (block.min >= min && block.max <= max);
+            for (uint64_t j = 0; j < block.numValues; j++)
+            {
+                const uint64_t v = static_cast<uint64_t>(decoded[j]);
+                if (allMatch || (v >= min && v <= max))
+                {
+                    values[numMatches] = decoded[j];
+                    positions[numMatches++] = start + j;
+                }
+            }
+        }
+        return numMatches;
+    }
+
+private:
+    const uint64_t *words; // the container, NULL until Open or Attach succeeds
+    uint64_t numWords;
+    void *mapping; // the mmap'd file, when there is one
+    size_t mappingBytes;
+};
+
+#if defined(SIMPLE8B_MMAP)
+/*
+    Streaming reader for container files on storage, overlapping the reads with the decoding.
+    Open reads the header and directory; Decode then starts a reader thread that reads the block
+    streams ahead with pread while the calling thread decodes the blocks already in, and hands
+    each block's values to a callback in order. At most queueDepth blocks are read ahead, so the
+    buffers stay at queueDepth times the largest block stream whatever the file's size.
+*/
+
+class Simple8bFilePipeline
+{
+public:
+    Simple8bFilePipeline() : fd(-1), fileWords(0), queueDepth(0), slotWords(0) {}
+
+    Simple8bFilePipeline(const Simple8bFilePipeline &) = delete;
+    Simple8bFilePipeline &operator=(const Simple8bFilePipeline &) = delete;
+
+    ~Simple8bFilePipeline()
+    {
+        Close();
+    }
+
+    // opens the file and reads its directory, with up to depth blocks read ahead while decoding;
+    // returns false if it cannot be read or is not a valid container
+    bool Open(const char *path, uint32_t depth = 4)
+    {
+        Close();
+        fd = open(path, O_RDONLY);
+        struct stat info;
+        if (fd < 0 || fstat(fd, &info) != 0)
+        {
+            Close();
+            return false;
+        }
+        fileWords = static_cast<uint64_t>(info.st_size) / sizeof(uint64_t);
+
+        head.resize(SIMPLE8B_FILE_HEADER_WORDS);
+        if (fileWords < SIMPLE8B_FILE_HEADER_WORDS || !Read(head.data(), 0, SIMPLE8B_FILE_HEADER_WORDS) ||
+            head[2] > (fileWords - SIMPLE8B_FILE_HEADER_WORDS) / SIMPLE8B_FILE_BLOCK_WORDS)
+        {
+            Close();
+            return false;
+        }
+        const uint64_t directoryWords = SIMPLE8B_FILE_BLOCK_WORDS * head[2];
+        head.resize(SIMPLE8B_FILE_HEADER_WORDS + directoryWords);
+        if (!Read(head.data() + SIMPLE8B_FILE_HEADER_WORDS, SIMPLE8B_FILE_HEADER_WORDS, directoryWords) ||
+            !CheckFileDirectory(head.data(), fileWords))
+        {
+            Close();
+            return false;
+        }
+
+        slotWords = 0;
+        for (uint64_t i = 0; i < NumBlocks(); i++)
+            slotWords = std::max(slotWords, BlockWords(i));
+        queueDepth = std::max<uint32_t>(depth, 1);
+        slots.resize(queueDepth * slotWords);
+        return true;
+    }
+
+    void Close()
+    {
+        if (fd >= 0)
+            close(fd);
+        fd = -1;
+        fileWords = 0;
+        head.clear();
+    }
+
+    bool IsOpen() const
+    {
+        return fd >= 0;
+    }
+
+    // total number of values
+    uint64_t Length() const
+    {
+        return head[1];
+    }
+
+    uint64_t NumBlocks() const
+    {
+        return head[2];
+    }
+
+    Simple8bFileBlock Block(uint64_t i) const
+    {
+        const uint64_t *const entry = head.data() + SIMPLE8B_FILE_HEADER_WORDS + SIMPLE8B_FILE_BLOCK_WORDS * i;
+        return {entry[0], entry[1], entry[2], entry[3], entry[4]};
+    }
+
+    // position of the first value of block i
+    uint64_t BlockStart(uint64_t i) const
+    {
+        return i * head[3];
+    }
+
+    // decodes every block, calling consume(i, values, numValues) with block i's values in order
+    // (values only stays valid during the call); returns Length(), or
+    // SIMPLE8B_ERROR_INPUT_TRUNCATED if a read fails or a block's stream ends early, after
+    // passing on the blocks before it
+    template <typename T, typename F>
+    uint64_t Decode(F consume)
+    {
+        std::vector<T> values(head[3]);
+        Progress progress;
+        std::thread reader(&Simple8bFilePipeline::ReadAhead, this, std::ref(progress));
+
+        uint64_t result = Length();
+        for (uint64_t i = 0; i < NumBlocks(); i++)
+        {
+            {
+                std::unique_lock<std::mutex> lock(progress.mutex);
+                progress.filled.wait(lock, [&]() { return progress.numRead > i || progress.failed; });
+                if (progress.numRead <= i)
+                {
+                    result = SIMPLE8B_ERROR_INPUT_TRUNCATED;
+                    break;
+                }
+            }
+            const uint64_t numValues = Block(i).numValues;
+            if (Simple8bDecodeChecked(Slot(i), BlockWords(i), numValues, values.data()) ==
+                SIMPLE8B_ERROR_INPUT_TRUNCATED)
+            {
+                result = SIMPLE8B_ERROR_INPUT_TRUNCATED;
+                break;
+            }
+            consume(i, static_cast<const T *>(values.data()), numValues);
+
+            // the reader is woken once every half queue, not once per block: it then reads
+            // several blocks in a row instead of sleeping again after each
+            const uint64_t wakeInterval = (queueDepth + 1) / 2;
+            {
+                std::lock_guard<std::mutex> lock(progress.mutex);
+                progress.numDecoded = i + 1;
+            }
+            if ((i + 1) % wakeInterval == 0)
+                progress.freed.notify_one();
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(progress.mutex);
+            progress.stopping = true;
+        }
+        progress.freed.notify_one();
+        reader.join();
+        return result;
+    }
+
+private:
+    // hand-off between Decode and its reader thread
+    struct Progress
+    {
+        std::mutex mutex;
+        std::condition_variable filled; // a block has been read
+        std::condition_variable freed;  // a block has been decoded, freeing its slot
+        uint64_t numRead = 0;
+        uint64_t numDecoded = 0;
+        bool failed = false;
+        bool stopping = false;
+    };
+
+    // reads the blocks in order, each once its slot's previous block has been decoded
+    void ReadAhead(Progress &progress)
+    {
+        for (uint64_t i = 0; i < NumBlocks(); i++)
+        {
+            {
+                std::unique_lock<std::mutex> lock(progress.mutex);
+                progress.freed.wait(lock, [&]() { return progress.stopping || i - progress.numDecoded < queueDepth; });
+                if (progress.stopping)
+                    return;
+            }
+            const bool ok = Read(Slot(i), Block(i).offset, BlockWords(i));
+            {
+                std::lock_guard<std::mutex> lock(progress.mutex);
+                if (ok)
+                    progress.numRead = i + 1;
+                progress.failed = !ok;
+            }
+            progress.filled.notify_one();
+            if (!ok)
+                return;
+        }
+    }
+
+    // words of block i's stream: up to the next block's, or to the end of the file
+    uint64_t BlockWords(uint64_t i) const
+    {
+        const uint64_t end = (i + 1 < NumBlocks()) ? Block(i + 1).offset : fileWords;
+        return end - Block(i).offset;
+    }
+
+    uint64_t *Slot(uint64_t i)
+    {
+        return slots.data() + (i % queueDepth) * slotWords;
+    }
+
+    // reads numWords words from word offset of the file, retrying short reads
+    bool Read(uint64_t *out, uint64_t offset, uint64_t numWords) const
+    {
+        char *bytes = reinterpret_cast<char *>(out);
+        size_t remaining = numWords * sizeof(uint64_t);
+        off_t position = static_cast<off_t>(offset * sizeof(uint64_t));
+        while (remaining > 0)
+        {
+            const ssize_t n = pread(fd, bytes, remaining, position);
+            if (n <= 0)
+                return false;
+            bytes += n;
+            remaining -= static_cast<size_t>(n);
+            position += n;
+        }
+        return true;
+    }
+
+    int fd;
+    uint64_t fileWords;
+    std::vector<uint64_t> head; // header and directory
+    uint32_t queueDepth;
+    uint64_t slotWords; // words of the largest block stream
+    std::vector<uint64_t> slots; // queueDepth block streams, block i in slot i % queueDepth
+};
+#endif
+
+/*
+    Columnar block of (timestamp, value) series. Series scraped together have identical
+    timestamp columns, so each distinct timestamp column is stored once, delta-of-delta coded,
+    and referenced by index from every value column using it; value columns are delta + zigzag
+    coded. Simple8bColumnsEncode finds the shared columns itself by comparing the timestamp
+    arrays it is given.
+
+    Layout, in 64-bit words:
+        [0]                                     SIMPLE8B_COLUMNS_MAGIC
+        [1]                                     number of timestamp columns, K
+        [2]                                     number of series, N
+        [3 + 2k], [4 + 2k]                      timestamp column k: word offset of its stream
+                                                from the start of the block, number of values
+        [3 + 2K + 2i], [4 + 2K + 2i]            series i: word offset of its value stream, and
+                                                its timestamp column (it has that many values)
+        ...                                     the streams, timestamp columns first
+    Every stream ends where the next one starts, the last one at the end of the block.
+*/
+
+const uint64_t SIMPLE8B_COLUMNS_MAGIC = 0x31534C4F43423853ULL; // "S8BCOLS1"
+const uint64_t SIMPLE8B_COLUMNS_HEADER_WORDS = 3;
+
+// size, in words, of the buffer Simple8bColumnsEncode needs for series of these lengths
+inline uint64_t Simple8bColumnsMaxWords(const uint64_t *lengths, uint64_t numSeries)
+{
+    uint64_t numWords = SIMPLE8B_COLUMNS_HEADER_WORDS + 4 * numSeries;
+    for (uint64_t i = 0; i < numSeries; i++)
+        numWords += 2 * Simple8bMaxCompressedSize(lengths[i]);
+    return numWords;
+}
+
+// encodes numSeries series, series i being the lengths[i] pairs (timestamps[i][j], values[i][j]),
+// into out (Simple8bColumnsMaxWords words); series with equal timestamps share one column.
+// Returns the number of words written, or SIMPLE8B_ERROR_VALUE_TOO_LARGE if a delta does not fit
+// in a word
+template <typename T>
+uint64_t Simple8bColumnsEncode(const int64_t *const *timestamps, const T *const *values, const uint64_t *lengths,
+                               uint64_t numSeries, uint64_t *out)
+{
+    // columnSeries[k]: first series with timestamp column k
+    std::vector<uint64_t> columnOf(numSeries);
+    std::vector<uint64_t> columnSeries;
+    for (uint64_t i = 0; i < numSeries; i++)
+    {
+        uint64_t k = 0;
+        for (; k < columnSeries.size(); k++)
+        {
+            const uint64_t first = columnSeries[k];
+            if (lengths[first] == lengths[i] &&
+                (timestamps[first] == timestamps[i] ||
+                 std::equal(timestamps[i], timestamps[i] + lengths[i], timestamps[first])))
+                break;
+        }
+        if (k == columnSeries.size())
+            columnSeries.push_back(i);
+        columnOf[i] = k;
+    }
+
+    const uint64_t numColumns = columnSeries.size();
+    uint64_t *const columnEntries = out + SIMPLE8B_COLUMNS_HEADER_WORDS;
+    uint64_t *const seriesEntries = columnEntries + 2 * numColumns;
+    out[0] = SIMPLE8B_COLUMNS_MAGIC;
+    out[1] = numColumns;
+    out[2] = numSeries;
+
+    uint64_t offset = SIMPLE8B_COLUMNS_HEADER_WORDS + 2 * numColumns + 2 * numSeries;
+    for (uint64_t k = 0; k < numColumns; k++)
+    {
+        const uint64_t first = columnSeries[k];
+        const uint64_t numWords = Simple8bDeltaOfDeltaEncode(timestamps[first], lengths[first], out + offset);
+        if (numWords == SIMPLE8B_ERROR_VALUE_TOO_LARGE)
+            return SIMPLE8B_ERROR_VALUE_TOO_LARGE;
+        columnEntries[2 * k] = offset;
+        columnEntries[2 * k + 1] = lengths[first];
+        offset += numWords;
+    }
+    for (uint64_t i = 0; i < numSeries; i++)
+    {
+        const uint64_t numWords = Simple8bDeltaZigZagEncode(values[i], lengths[i], out + offset);
+        if (numWords == SIMPLE8B_ERROR_VALUE_TOO_LARGE)
+            return SIMPLE8B_ERROR_VALUE_TOO_LARGE;
+        seriesEntries[2 * i] = offset;
+        seriesEntries[2 * i + 1] = columnOf[i];
+        offset += numWords;
+    }
+
+    return offset;
+}
+
+// true when the numWords words at in hold at least numValues values
+inline bool HoldsValues(const uint64_t *in, uint64_t numWords, uint64_t numValues)
+{
+    uint64_t position = 0;
+    for (uint64_t i = 0; i < numWords && position < numValues; i++)
+        position += SIMPLE8B_SELECTOR_INTEGERS[GetSelectorNum(in + i)];
+    return position >= numValues;
+}
+
+/*
+    Read-only view of a Simple8bColumnsEncode block in memory. Attach checks the directory and
+    that every stream holds its values, so decoding a valid-looking block stays in bounds. Decode
+    unpacks each timestamp column once, however many series share it, and spreads the columns
+    over threads.
+*/
+
+class Simple8bColumnsReader
+{
+public:
+    Simple8bColumnsReader() : words(NULL), numWords(0) {}
+
+    // reads a block from memory, which must stay valid for as long as the reader uses it;
+    // returns false if it is not a valid block
+    bool Attach(const uint64_t *input, uint64_t inputWords)
+    {
+        words = NULL;
+        numWords = 0;
+        if (inputWords < SIMPLE8B_COLUMNS_HEADER_WORDS || input[0] != SIMPLE8B_COLUMNS_MAGIC ||
+            input[1] > (inputWords - SIMPLE8B_COLUMNS_HEADER_WORDS) / 2 ||
+            input[2] > (inputWords - SIMPLE8B_COLUMNS_HEADER_WORDS) / 2 - input[1])
+            return false;
+
+        // every stream starts after the previous one, timestamp columns first
+        words = input;
+        numWords = inputWords;
+        const uint64_t numStreams = NumTimestampColumns() + NumSeries();
+        uint64_t offset = SIMPLE8B_COLUMNS_HEADER_WORDS + 2 * numStreams;
+        for (uint64_t s = 0; s < numStreams; s++)
+        {
+            const uint64_t *const entry = input + SIMPLE8B_COLUMNS_HEADER_WORDS + 2 * s;
+            bool valid = entry[0] >= offset && entry[0] <= inputWords;
+            if (s >= NumTimestampColumns())
+                valid = valid && entry[1] < NumTimestampColumns();
+            if (!valid)
+            {
+                words = NULL;
+                numWords = 0;
+                return false;
+            }
+            offset = entry[0];
+        }
+        for (uint64_t s = 0; s < numStreams; s++)
+        {
+            const uint64_t *const entry = input + SIMPLE8B_COLUMNS_HEADER_WORDS + 2 * s;
+            const uint64_t numValues = (s < NumTimestampColumns()) ? entry[1] : ColumnLength(entry[1]);
+            if (!HoldsValues(input + entry[0], StreamEnd(s) - entry[0], numValues))
+            {
+                words = NULL;
+                numWords = 0;
+                return false;
+            }
+        }
+        return true;
+    }
+
+    bool IsOpen() const
+    {
+        return words != NULL;
+    }
+
+    uint64_t NumTimestampColumns() const
+    {
+        return words[1];
+    }
+
+    uint64_t NumSeries() const
+    {
+        return words[2];
+    }
+
+    uint64_t ColumnLength(uint64_t k) const
+    {
+        return words[SIMPLE8B_COLUMNS_HEADER_WORDS + 2 * k + 1];
+    }
+
+    // timestamp column of series i
+    uint64_t TimestampColumn(uint64_t i) const
+    {
+        return words[SIMPLE8B_COLUMNS_HEADER_WORDS + 2 * (NumTimestampColumns() + i) + 1];
+    }
+
+    // number of (timestamp, value) pairs of series i
+    uint64_t Length(uint64_t i) const
+    {
+        return ColumnLength(TimestampColumn(i));
+    }
+
+    // decodes timestamp column k into out (ColumnLength(k) values); returns that count
+    uint64_t DecodeTimestamps(uint64_t k, int64_t *out) const
+    {
+        return Simple8bDeltaOfDeltaDecode(Stream(k), ColumnLength(k), out);
+    }
+
+    // decodes the values of series i, of the type they were encoded from, into out (Length(i)
+    // values); returns that count
+    template <typename T>
+    uint64_t DecodeValues(uint64_t i, T *out) const
+    {
+        return Simple8bDeltaZigZagDecode(Stream(NumTimestampColumns() + i), Length(i), out);
+    }
+
+    // decodes every timestamp column k into timestamps[k] and every series' values into
+    // values[i], on up to numThreads threads (0 = one per core; see Simple8bContext for
+    // context); returns the total number of values and timestamps decoded
+    template <typename T>
+    uint64_t Decode(int64_t *const *timestamps, T *const *values, uint32_t numThreads = 1,
+                    Simple8bContext *context = NULL) const
+    {
+        Simple8bContext local;
+        Simple8bContext &shared = (context != NULL) ? *context : local;
+        const uint64_t numColumns = NumTimestampColumns();
+        shared.Run(numColumns + NumSeries(), numThreads, [&](uint64_t s)
+                   {
+                       if (s < numColumns)
+                           DecodeTimestamps(s, timestamps[s]);
+                       else
+                           DecodeValues(s - numColumns, values[s - numColumns]);
+                   });
+
+        uint64_t numDecoded = 0;
+        for (uint64_t k = 0; k < numColumns; k++)
+            numDecoded += ColumnLength(k);
+        for (uint64_t i = 0; i < NumSeries(); i++)
+            numDecoded += Length(i);
+        return numDecoded;
+    }
+
+private:
+    // stream s: timestamp column s, or the values of series s - NumTimestampColumns(). The
+    // decoders take mutable pointers but only read
+    uint64_t *Stream(uint64_t s) const
+    {
+        return const_cast<uint64_t *>(words + words[SIMPLE8B_COLUMNS_HEADER_WORDS + 2 * s]);
+    }
+
+    uint64_t StreamEnd(uint64_t s) const
+    {
+        const uint64_t numStreams = NumTimestampColumns() + NumSeries();
+        return (s + 1 < numStreams) ? words[SIMPLE8B_COLUMNS_HEADER_WORDS + 2 * (s + 1)] : numWords;
+    }
+
+    const uint64_t *words; // the block, NULL until Attach succeeds
+    uint64_t numWords;
+};
+
+#endif // SIMPLE8B_HPP
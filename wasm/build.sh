@@ -0,0 +1,16 @@
+#!/bin/sh
+# Builds simple8b_wasm.mjs (+ .wasm) with Emscripten, using the SIMD128 unpack kernels.
+# Browsers without wasm SIMD need a second build with SIMD=0.
+set -e
+cd "$(dirname "$0")"
+
+SIMD_FLAGS="-msimd128"
+if [ "${SIMD:-1}" = "0" ]; then
+    SIMD_FLAGS=""
+fi
+
+emcc -O3 -std=c++17 $SIMD_FLAGS -I.. \
+    ../simple8b.cpp simple8b_wasm.cpp \
+    -sMODULARIZE=1 -sEXPORT_ES6=1 -sEXPORT_NAME=createSimple8bModule \
+    -sALLOW_MEMORY_GROWTH=1 -sEXPORTED_FUNCTIONS=_malloc,_free -sEXPORTED_RUNTIME_METHODS=HEAPU8 \
+    -o simple8b_wasm.mjs
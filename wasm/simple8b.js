@@ -0,0 +1,142 @@
+/*
+    JavaScript wrapper over the wasm build (see build.sh).
+
+    Values are decoded straight into buffers on the wasm heap and returned as TypedArray views
+    over them, so nothing is copied on the way out. The views are reused: they stay valid until
+    the next decode call on the same instance (copy with .slice() to keep them longer).
+
+        const codec = await Simple8b.create();
+        const values = codec.decode(words, length, "u32");           // Uint32Array view
+        const series = codec.decodeMany([{ words, length }, ...], "i64");
+*/
+
+import createSimple8bModule from "./simple8b_wasm.mjs";
+
+const TYPES = {
+    u8: [Uint8Array, "U8"],
+    u16: [Uint16Array, "U16"],
+    u32: [Uint32Array, "U32"],
+    u64: [BigUint64Array, "U64"],
+    i8: [Int8Array, "I8"],
+    i16: [Int16Array, "I16"],
+    i32: [Int32Array, "I32"],
+    i64: [BigInt64Array, "I64"],
+};
+
+const WORD_BYTES = 8;
+
+export class Simple8b {
+    static async create(factory = createSimple8bModule) {
+        return new Simple8b(await factory());
+    }
+
+    constructor(module) {
+        this.module = module;
+        this.buffers = {}; // name -> { pointer, bytes }, grown on demand and reused
+    }
+
+    // wasm heap buffer of at least the given size, kept across calls
+    reserve(name, bytes) {
+        const buffer = this.buffers[name];
+        if (buffer && buffer.bytes >= bytes) {
+            return buffer.pointer;
+        }
+        if (buffer) {
+            this.module._free(buffer.pointer);
+        }
+        const size = Math.max(bytes, 2 * (buffer ? buffer.bytes : 0), 64);
+        const pointer = this.module._malloc(size);
+        if (pointer === 0) {
+            throw new RangeError("simple8b: out of wasm memory");
+        }
+        this.buffers[name] = { pointer, bytes: size };
+        return pointer;
+    }
+
+    // the heap changes buffer when memory grows, so views are always made from the current one
+    heap() {
+        return this.module.HEAPU8.buffer;
+    }
+
+    // BigUint64Array of numWords words on the wasm heap: fill it (eg from a fetch) and pass it to
+    // decode to skip the input copy too. Valid until the next allocWords call
+    allocWords(numWords) {
+        const pointer = this.reserve("words", numWords * WORD_BYTES);
+        return new BigUint64Array(this.heap(), pointer, numWords);
+    }
+
+    // copies words (BigUint64Array, ArrayBuffer or Uint8Array of the encoded bytes) to the heap
+    // unless they are already there; returns their heap address
+    placeWords(words, name) {
+        const bytes = words instanceof ArrayBuffer ? new Uint8Array(words)
+            : new Uint8Array(words.buffer, words.byteOffset, words.byteLength);
+        if (bytes.buffer === this.heap()) {
+            return bytes.byteOffset;
+        }
+        const pointer = this.reserve(name, bytes.byteLength);
+        new Uint8Array(this.heap(), pointer, bytes.byteLength).set(bytes);
+        return pointer;
+    }
+
+    decode(words, length, type = "u64") {
+        const [ArrayType, suffix] = TYPES[type];
+        const numWords = Math.floor(words.byteLength / WORD_BYTES);
+        const input = this.placeWords(words, "input");
+        const output = this.reserve("output", length * ArrayType.BYTES_PER_ELEMENT);
+        if (this.module["_Simple8bWasmDecode" + suffix](input, numWords, length, output) < 0) {
+            throw new RangeError("simple8b: compressed stream ends before the requested number of values");
+        }
+        return new ArrayType(this.heap(), output, length);
+    }
+
+    // decodes every { words, length } of series in one wasm call; returns one view per series,
+    // all over a single contiguous output buffer
+    decodeMany(series, type = "u64") {
+        const [ArrayType, suffix] = TYPES[type];
+        const numStreams = series.length;
+        let totalWords = 0;
+        let totalLength = 0;
+        for (const { words, length } of series) {
+            totalWords += Math.floor(words.byteLength / WORD_BYTES);
+            totalLength += length;
+        }
+
+        // reserve everything first: a later malloc may grow memory and detach earlier views
+        const input = this.reserve("input", totalWords * WORD_BYTES);
+        const counts = this.reserve("counts", 2 * numStreams * Uint32Array.BYTES_PER_ELEMENT);
+        const output = this.reserve("output", totalLength * ArrayType.BYTES_PER_ELEMENT);
+
+        const heapBytes = new Uint8Array(this.heap());
+        const inputWords = new Uint32Array(this.heap(), counts, numStreams);
+        const lengths = new Uint32Array(this.heap(), counts + numStreams * Uint32Array.BYTES_PER_ELEMENT, numStreams);
+        let offset = input;
+        series.forEach(({ words, length }, i) => {
+            const bytes = words instanceof ArrayBuffer ? new Uint8Array(words)
+                : new Uint8Array(words.buffer, words.byteOffset, words.byteLength);
+            inputWords[i] = Math.floor(bytes.byteLength / WORD_BYTES);
+            lengths[i] = length;
+            heapBytes.set(bytes.subarray(0, inputWords[i] * WORD_BYTES), offset);
+            offset += inputWords[i] * WORD_BYTES;
+        });
+
+        if (this.module["_Simple8bWasmDecodeBatch" + suffix](input, counts, lengths.byteOffset, numStreams, output) < 0) {
+            throw new RangeError("simple8b: compressed stream ends before the requested number of values");
+        }
+
+        const views = [];
+        let position = output;
+        for (const { length } of series) {
+            views.push(new ArrayType(this.heap(), position, length));
+            position += length * ArrayType.BYTES_PER_ELEMENT;
+        }
+        return views;
+    }
+
+    // frees the heap buffers; views returned earlier must not be used afterwards
+    dispose() {
+        for (const name of Object.keys(this.buffers)) {
+            this.module._free(this.buffers[name].pointer);
+        }
+        this.buffers = {};
+    }
+}
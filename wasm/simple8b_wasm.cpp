@@ -0,0 +1,60 @@
+/*
+    WebAssembly entry points used by simple8b.js, built on top of the C ABI in simple8b.h.
+
+    Lengths and counts are 32-bit, like wasm32 addresses, so JavaScript calls them with plain
+    numbers instead of BigInts. The batch decoders walk many streams in a single call, which
+    pays the JS <-> wasm transition once per batch instead of once per series.
+*/
+
+#include "simple8b.h"
+
+// decodes one stream; returns the number of values decoded, or -1 if the stream is truncated
+template <typename T, uint64_t (*Decode)(const uint64_t *, uint64_t, uint64_t, T *)>
+static int32_t DecodeOne(const uint64_t *input, uint32_t inputWords, uint32_t length, T *output)
+{
+    const uint64_t decoded = Decode(input, inputWords, length, output);
+    return (decoded == SIMPLE8B_ERROR_INPUT_TRUNCATED) ? -1 : static_cast<int32_t>(decoded);
+}
+
+// decodes numStreams streams stored back to back in input (inputWords[i] words each) into
+// output, back to back (lengths[i] values each); returns the total number of values, or -1 if
+// a stream is truncated
+template <typename T, uint64_t (*Decode)(const uint64_t *, uint64_t, uint64_t, T *)>
+static int32_t DecodeBatch(const uint64_t *input, const uint32_t *inputWords, const uint32_t *lengths,
+                           uint32_t numStreams, T *output)
+{
+    uint32_t total = 0;
+    for (uint32_t i = 0; i < numStreams; i++)
+    {
+        if (Decode(input, inputWords[i], lengths[i], output) == SIMPLE8B_ERROR_INPUT_TRUNCATED)
+            return -1;
+        input += inputWords[i];
+        output += lengths[i];
+        total += lengths[i];
+    }
+    return static_cast<int32_t>(total);
+}
+
+#define SIMPLE8B_WASM_TYPE(suffix, type)                                                                      \
+    EXPORT int32_t Simple8bWasmDecode##suffix(const uint64_t *input, uint32_t inputWords, uint32_t length,    \
+                                              type *output)                                                   \
+    {                                                                                                         \
+        return DecodeOne<type, Simple8bDecodeChecked##suffix>(input, inputWords, length, output);             \
+    }                                                                                                         \
+    EXPORT int32_t Simple8bWasmDecodeBatch##suffix(const uint64_t *input, const uint32_t *inputWords,         \
+                                                   const uint32_t *lengths, uint32_t numStreams, type *output) \
+    {                                                                                                         \
+        return DecodeBatch<type, Simple8bDecodeChecked##suffix>(input, inputWords, lengths, numStreams, output); \
+    }
+
+extern "C"
+{
+    SIMPLE8B_WASM_TYPE(U8, uint8_t)
+    SIMPLE8B_WASM_TYPE(U16, uint16_t)
+    SIMPLE8B_WASM_TYPE(U32, uint32_t)
+    SIMPLE8B_WASM_TYPE(U64, uint64_t)
+    SIMPLE8B_WASM_TYPE(I8, int8_t)
+    SIMPLE8B_WASM_TYPE(I16, int16_t)
+    SIMPLE8B_WASM_TYPE(I32, int32_t)
+    SIMPLE8B_WASM_TYPE(I64, int64_t)
+}